@@ -0,0 +1,121 @@
+/* Batched encode, check and decode for the CCSDS (255,223) codes
+ * The kernels are looked up once per batch and the next block is
+ * prefetched while the current one is processed, so long sweeps over
+ * many blocks are not bound by the memory latency of each block
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <stddef.h>
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+/* Fetch the symbols of a block ahead of use */
+static inline void prefetch_block(const data_t *data,const data_t *parity,int len){
+  int i;
+
+  for(i=0;i<len;i+=64)
+    __builtin_prefetch(&data[i]);
+  __builtin_prefetch(&parity[0]);
+  __builtin_prefetch(&parity[NROOTS-1]);
+}
+
+/* Parity of block i, which follows its data if parity is NULL */
+static inline data_t *parity_of(data_t **data,data_t **parity,int i,int pad){
+  return (parity != NULL) ? parity[i] : &data[i][NN-NROOTS-pad];
+}
+
+void encode_rs_8_batch(data_t **data,data_t **parity,int count,int pad){
+  const struct rs_8_kernels *k = rs_8_kernels();
+  int i;
+
+  for(i=0;i<count;i++){
+    if(i+1 < count)
+      prefetch_block(data[i+1],parity_of(data,parity,i+1,pad),NN-NROOTS-pad);
+    k->encode(data[i],parity_of(data,parity,i,pad),pad);
+  }
+}
+
+void encode_rs_ccsds_batch(data_t **data,data_t **parity,int count,int pad){
+  int i;
+
+  for(i=0;i<count;i++){
+    if(i+1 < count)
+      prefetch_block(data[i+1],parity_of(data,parity,i+1,pad),NN-NROOTS-pad);
+    encode_rs_ccsds(data[i],parity_of(data,parity,i,pad),pad);
+  }
+}
+
+/* Common loop of the check functions */
+static int check_batch(data_t **data,data_t **parity,int count,int pad,int *result,const data_t *basis){
+  const struct rs_8_kernels *k = rs_8_kernels();
+  int errors = 0;
+  int i;
+
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+  for(i=0;i<count;i++){
+    int r;
+
+    if(i+1 < count)
+      prefetch_block(data[i+1],parity_of(data,parity,i+1,pad),NN-NROOTS-pad);
+    r = k->check(data[i],NN-NROOTS-pad,parity_of(data,parity,i,pad),basis);
+    if(result != NULL)
+      result[i] = r;
+    if(r != 0)
+      errors++;
+  }
+  return errors;
+}
+
+int check_rs_8_batch(data_t **data,data_t **parity,int count,int pad,int *result){
+  return check_batch(data,parity,count,pad,result,NULL);
+}
+
+int check_rs_ccsds_batch(data_t **data,data_t **parity,int count,int pad,int *result){
+  rs_8_kernels(); /* Builds Rs_8_tal1nib */
+  return check_batch(data,parity,count,pad,result,Rs_8_tal1nib);
+}
+
+int decode_rs_8_batch(data_t **data,int count,int pad,int *result){
+  const struct rs_8_kernels *k = rs_8_kernels();
+  int failures = 0;
+  int i;
+
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+  for(i=0;i<count;i++){
+    int r;
+
+    if(i+1 < count)
+      prefetch_block(data[i+1],&data[i+1][NN-NROOTS-pad],NN-NROOTS-pad);
+    r = k->decode(data[i],NULL,0,pad);
+    if(result != NULL)
+      result[i] = r;
+    if(r < 0)
+      failures++;
+  }
+  return failures;
+}
+
+int decode_rs_ccsds_batch(data_t **data,int count,int pad,int *result){
+  int failures = 0;
+  int i;
+
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+  for(i=0;i<count;i++){
+    int r;
+
+    if(i+1 < count)
+      prefetch_block(data[i+1],&data[i+1][NN-NROOTS-pad],NN-NROOTS-pad);
+    r = decode_rs_ccsds(data[i],NULL,0,pad);
+    if(result != NULL)
+      result[i] = r;
+    if(r < 0)
+      failures++;
+  }
+  return failures;
+}
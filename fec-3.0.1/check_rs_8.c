@@ -0,0 +1,53 @@
+/* Check-only Reed-Solomon verification for the CCSDS (255,223) code
+ * Computes the syndromes in place over separate data and parity buffers,
+ * without copying the block or running the decoder
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+int check_rs_8(data_t *data,data_t *parity,int pad){
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+  return rs_8_kernels()->check(data,NN-NROOTS-pad,parity,NULL);
+}
+
+int check_rs_ccsds(data_t *data,data_t *parity,int pad){
+  const struct rs_8_kernels *k;
+
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+  k = rs_8_kernels(); /* Builds Rs_8_tal1nib */
+  return k->check(data,NN-NROOTS-pad,parity,Rs_8_tal1nib);
+}
+
+/* Portable C version */
+int check_rs_8_port(const data_t *data,int len,const data_t *parity,const data_t *basis){
+  data_t s[NROOTS],root[NROOTS];
+  data_t syn_error = 0;
+  int i,j;
+
+  memset(s,0,sizeof(s));
+  for(i=0;i<NROOTS;i++)
+    root[i] = MODNN((FCR+i)*PRIM);
+  for(j=0;j<len+NROOTS;j++){
+    data_t x = (j < len) ? data[j] : parity[j-len];
+
+    if(basis != NULL)
+      x = basis[x & 15] ^ basis[16 + (x >> 4)];
+    for(i=0;i<NROOTS;i++){
+      if(s[i] == 0){
+	s[i] = x;
+      } else {
+	s[i] = x ^ ALPHA_SUM(INDEX_OF[s[i]],root[i]);
+      }
+    }
+  }
+  for(i=0;i<NROOTS;i++)
+    syn_error |= s[i];
+  return syn_error != 0;
+}
@@ -15,11 +15,24 @@
  * INDEX_OF - The address of an array of NN elements to convert Galois field
  *            elements in polynomial form to index (log) form. Read only.
  * MODNN - a function to reduce its argument modulo NN. May be inline or a macro.
+ * ALPHA_SUM - Optional. ALPHA_SUM(a,b) is ALPHA_TO[MODNN(a+b)] for index-form a and b
+ *             less than NN, typically a load from an antilog table of 2*NN elements.
  * FCR - An integer literal or variable specifying the first consecutive root of the
  *       Reed-Solomon generator polynomial. Integer variable or literal.
  * PRIM - The primitive root of the generator poly. Integer variable or literal.
  * DEBUG - If set to 1 or more, do various internal consistency checking. Leave this
  *         undefined for production code
+ * SYNDROMES - Optional. SYNDROMES(s) fills s[] with the syndromes in poly-form,
+ *             replacing the built-in scalar evaluation.
+ * CHIEN_FORNEY - Optional. CHIEN_FORNEY(lambda,deg_lambda,omega,deg_omega,loc,err)
+ *                finds the roots of the index-form lambda[] like the built-in search,
+ *                stopping at deg_lambda roots, fills loc[] with the error locations
+ *                and err[] with the poly-form error values given by the index-form
+ *                omega[], and evaluates to the number of roots found.
+ * FAST_DECODE - Optional. FAST_DECODE(s,loc) is tried first when there are no
+ *               erasures. Given the index-form syndromes, it either corrects data[],
+ *               fills loc[] and evaluates to the number of errors, or evaluates to 0
+ *               to fall back to the general decoder.
 
  * The memset(), memmove(), and memcpy() functions are used. The appropriate header
  * file declaring these functions (usually <string.h>) must be included by the calling
@@ -63,6 +76,10 @@
 #define NULL ((void *)0)
 #endif
 
+#if !defined(ALPHA_SUM)
+#define ALPHA_SUM(a,b) ALPHA_TO[MODNN((a)+(b))]
+#endif
+
 #undef MIN
 #define	MIN(a,b)	((a) < (b) ? (a) : (b))
 #undef A0
@@ -76,21 +93,31 @@
 					 * and syndrome poly */
   data_t b[NROOTS+1], t[NROOTS+1], omega[NROOTS+1];
   data_t root[NROOTS], reg[NROOTS+1], loc[NROOTS];
+#ifdef CHIEN_FORNEY
+  data_t err[NROOTS];
+#endif
   int syn_error, count;
 
   /* form the syndromes; i.e., evaluate data(x) at roots of g(x) */
-  for(i=0;i<NROOTS;i++)
+#ifdef SYNDROMES
+  SYNDROMES(s);
+#else
+  /* root[] holds the roots of g(x) in index form until the Chien search */
+  for(i=0;i<NROOTS;i++){
     s[i] = data[0];
+    root[i] = MODNN((FCR+i)*PRIM);
+  }
 
   for(j=1;j<NN-PAD;j++){
     for(i=0;i<NROOTS;i++){
       if(s[i] == 0){
 	s[i] = data[j];
       } else {
-	s[i] = data[j] ^ ALPHA_TO[MODNN(INDEX_OF[s[i]] + (FCR+i)*PRIM)];
+	s[i] = data[j] ^ ALPHA_SUM(INDEX_OF[s[i]],root[i]);
       }
     }
   }
+#endif
 
   /* Convert syndromes to index form, checking for nonzero condition */
   syn_error = 0;
@@ -106,6 +133,12 @@
     count = 0;
     goto finish;
   }
+#ifdef FAST_DECODE
+  if(no_eras == 0 && (count = FAST_DECODE(s,loc)) > 0){
+    /* Few enough errors to correct in closed form */
+    goto finish;
+  }
+#endif
   memset(&lambda[1],0,NROOTS*sizeof(lambda[0]));
   lambda[0] = 1;
 
@@ -117,7 +150,7 @@
       for (j = i+1; j > 0; j--) {
 	tmp = INDEX_OF[lambda[j - 1]];
 	if(tmp != A0)
-	  lambda[j] ^= ALPHA_TO[MODNN(u + tmp)];
+	  lambda[j] ^= ALPHA_SUM(u,tmp);
       }
     }
 
@@ -171,7 +204,7 @@
     discr_r = 0;
     for (i = 0; i < r; i++){
       if ((lambda[i] != 0) && (s[r-i-1] != A0)) {
-	discr_r ^= ALPHA_TO[MODNN(INDEX_OF[lambda[i]] + s[r-i-1])];
+	discr_r ^= ALPHA_SUM(INDEX_OF[lambda[i]],s[r-i-1]);
       }
     }
     discr_r = INDEX_OF[discr_r];	/* Index form */
@@ -184,7 +217,7 @@
       t[0] = lambda[0];
       for (i = 0 ; i < NROOTS; i++) {
 	if(b[i] != A0)
-	  t[i+1] = lambda[i+1] ^ ALPHA_TO[MODNN(discr_r + b[i])];
+	  t[i+1] = lambda[i+1] ^ ALPHA_SUM(discr_r,b[i]);
 	else
 	  t[i+1] = lambda[i+1];
       }
@@ -212,7 +245,37 @@
     if(lambda[i] != A0)
       deg_lambda = i;
   }
+  /*
+   * Compute err+eras evaluator poly omega(x) = s(x)*lambda(x) (modulo
+   * x**NROOTS). in index form. Also find deg(omega).
+   */
+  deg_omega = deg_lambda-1;
+  for (i = 0; i <= deg_omega;i++){
+    tmp = 0;
+    for(j=i;j >= 0; j--){
+      if ((s[i - j] != A0) && (lambda[j] != A0))
+	tmp ^= ALPHA_SUM(s[i - j],lambda[j]);
+    }
+    omega[i] = INDEX_OF[tmp];
+  }
+
   /* Find roots of the error+erasure locator polynomial by Chien search */
+#ifdef CHIEN_FORNEY
+  count = CHIEN_FORNEY(lambda,deg_lambda,omega,deg_omega,loc,err);
+  if (deg_lambda != count) {
+    /*
+     * deg(lambda) unequal to number of roots => uncorrectable
+     * error detected
+     */
+    count = -1;
+    goto finish;
+  }
+  /* Apply errors to data */
+  for (j = 0; j < count; j++) {
+    if (err[j] != 0 && loc[j] >= PAD)
+      data[loc[j]-PAD] ^= err[j];
+  }
+#else
   memcpy(&reg[1],&lambda[1],NROOTS*sizeof(reg[0]));
   count = 0;		/* Number of roots of lambda(x) */
   for (i = 1,k=IPRIM-1; i <= NN; i++,k = MODNN(k+IPRIM)) {
@@ -245,20 +308,6 @@
     count = -1;
     goto finish;
   }
-  /*
-   * Compute err+eras evaluator poly omega(x) = s(x)*lambda(x) (modulo
-   * x**NROOTS). in index form. Also find deg(omega).
-   */
-  deg_omega = deg_lambda-1;
-  for (i = 0; i <= deg_omega;i++){
-    tmp = 0;
-    for(j=i;j >= 0; j--){
-      if ((s[i - j] != A0) && (lambda[j] != A0))
-	tmp ^= ALPHA_TO[MODNN(s[i - j] + lambda[j])];
-    }
-    omega[i] = INDEX_OF[tmp];
-  }
-
   /*
    * Compute error values in poly-form. num1 = omega(inv(X(l))), num2 =
    * inv(X(l))**(FCR-1) and den = lambda_pr(inv(X(l))) all in poly-form
@@ -289,6 +338,7 @@
       data[loc[j]-PAD] ^= ALPHA_TO[MODNN(INDEX_OF[num1] + INDEX_OF[num2] + NN - INDEX_OF[den])];
     }
   }
+#endif
  finish:
   if(eras_pos != NULL){
     for(i=0;i<count;i++)
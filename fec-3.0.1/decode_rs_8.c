@@ -10,14 +10,21 @@
 #include <string.h>
 
 #include "fixed.h"
+#include "rs_8_simd.h"
 
 int decode_rs_8(data_t *data, int *eras_pos, int no_eras, int pad){
+  return rs_8_kernels()->decode(data,eras_pos,no_eras,pad);
+}
+
+/* Portable C version */
+int decode_rs_8_port(data_t *data, int *eras_pos, int no_eras, int pad){
   int retval;
  
   if(pad < 0 || pad > 222){
     return -1;
   }
 
+#define FAST_DECODE(s,loc) fast_decode_rs_8(data,s,loc,PAD)
 #include "decode_rs.h"
   
   return retval;
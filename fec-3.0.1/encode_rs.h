@@ -16,6 +16,8 @@
  * INDEX_OF - The address of an array of NN elements to convert Galois field
  *            elements in polynomial form to index (log) form. Read only.
  * MODNN - a function to reduce its argument modulo NN. May be inline or a macro.
+ * ALPHA_SUM - Optional. ALPHA_SUM(a,b) is ALPHA_TO[MODNN(a+b)] for index-form a and b
+ *             less than NN, typically a load from an antilog table of 2*NN elements.
  * GENPOLY - an array of NROOTS+1 elements containing the generator polynomial in index form
 
  * The memset() and memmove() functions are used. The appropriate header
@@ -30,6 +32,10 @@
 #undef A0
 #define A0 (NN) /* Special reserved value encoding zero in index form */
 
+#if !defined(ALPHA_SUM)
+#define ALPHA_SUM(a,b) ALPHA_TO[MODNN((a)+(b))]
+#endif
+
 {
   int i, j;
   data_t feedback;
@@ -46,12 +52,12 @@
       feedback = MODNN(NN - GENPOLY[NROOTS] + feedback);
 #endif
       for(j=1;j<NROOTS;j++)
-	parity[j] ^= ALPHA_TO[MODNN(feedback + GENPOLY[NROOTS-j])];
+	parity[j] ^= ALPHA_SUM(feedback,GENPOLY[NROOTS-j]);
     }
     /* Shift */
     memmove(&parity[0],&parity[1],sizeof(data_t)*(NROOTS-1));
     if(feedback != A0)
-      parity[NROOTS-1] = ALPHA_TO[MODNN(feedback + GENPOLY[0])];
+      parity[NROOTS-1] = ALPHA_SUM(feedback,GENPOLY[0]);
     else
       parity[NROOTS-1] = 0;
   }
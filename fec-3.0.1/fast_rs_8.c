@@ -0,0 +1,106 @@
+/* Closed-form correction of one or two symbol errors for the CCSDS
+ * (255,223) code
+ * A single corrupted symbol, the usual result of a single-event upset, is
+ * located from the ratio of two consecutive syndromes; two errors are
+ * located by solving the quadratic error locator polynomial with a table.
+ * Anything else is left to the general decoder
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+#undef A0
+#define A0 (NN)
+
+/* Multiply two field elements in polynomial form */
+static inline data_t gf_mul(data_t a,data_t b){
+  if(a == 0 || b == 0)
+    return 0;
+  return ALPHA_SUM(INDEX_OF[a],INDEX_OF[b]);
+}
+
+/* Divide two field elements in polynomial form, b != 0 */
+static inline data_t gf_div(data_t a,data_t b){
+  if(a == 0)
+    return 0;
+  return ALPHA_SUM(INDEX_OF[a],NN - INDEX_OF[b]);
+}
+
+/* Apply the error value e' = e * X**FCR at the location whose locator is
+ * alpha**x, outside the padding, and return its position in the full block
+ */
+static inline int apply_error(data_t *data,int x,data_t e,int pad){
+  int l = NN - 1 - MODNN(x*IPRIM);
+
+  data[l-pad] ^= ALPHA_TO[MODNN(INDEX_OF[e] + NN*FCR - FCR*x)];
+  return l;
+}
+
+int fast_decode_rs_8(data_t *data,const data_t s[NROOTS],data_t loc[NROOTS],int pad){
+  data_t S[NROOTS];
+  data_t det,l1,l2,z,x1,x2,e1,e2;
+  int i,p1,p2;
+
+  /* One error: every syndrome is the previous one times the locator */
+  if(s[0] != A0 && s[1] != A0){
+    int x = MODNN(s[1] + NN - s[0]);
+
+    for(i=1;i<NROOTS-1;i++){
+      if(s[i+1] != MODNN(s[i] + x))
+	break;
+    }
+    if(i == NROOTS-1){
+      if(MODNN(x*IPRIM) > NN-1-pad)
+	return 0; /* In the padding, leave it to the general decoder */
+      loc[0] = apply_error(data,x,ALPHA_TO[s[0]],pad);
+      return 1;
+    }
+  }
+
+  /* Two errors: lambda(x) = 1 + l1*x + l2*x**2 from Newton's identities
+   * S[j+2] = l1*S[j+1] + l2*S[j], which must then hold for every j
+   */
+  for(i=0;i<NROOTS;i++)
+    S[i] = (s[i] == A0) ? 0 : ALPHA_TO[s[i]];
+  det = gf_mul(S[1],S[1]) ^ gf_mul(S[0],S[2]);
+  if(det == 0)
+    return 0;
+  l1 = gf_div(gf_mul(S[0],S[3]) ^ gf_mul(S[1],S[2]),det);
+  l2 = gf_div(gf_mul(S[1],S[3]) ^ gf_mul(S[2],S[2]),det);
+  if(l1 == 0 || l2 == 0)
+    return 0;
+  for(i=2;i<NROOTS-2;i++){
+    if(S[i+2] != (gf_mul(l1,S[i+1]) ^ gf_mul(l2,S[i])))
+      return 0;
+  }
+
+  /* The locators are the roots of X**2 + l1*X + l2; with X = l1*z this
+   * becomes z**2 + z = l2/l1**2
+   */
+  z = Rs_8_quadtab[gf_div(l2,gf_mul(l1,l1))];
+  if(z == 0)
+    return 0; /* Irreducible, more than two errors */
+  x1 = gf_mul(l1,z);
+  x2 = x1 ^ l1;
+  p1 = MODNN(INDEX_OF[x1]*IPRIM);
+  p2 = MODNN(INDEX_OF[x2]*IPRIM);
+  if(p1 > NN-1-pad || p2 > NN-1-pad)
+    return 0;
+
+  /* Error values from S[0] = e1 + e2 and S[1] = e1*X1 + e2*X2 */
+  e1 = gf_div(S[1] ^ gf_mul(S[0],x2),l1);
+  e2 = S[0] ^ e1;
+  if(e1 == 0 || e2 == 0)
+    return 0;
+  /* Report the positions in the order the Chien search finds them, which
+   * tries the root alpha**(NN-x) of each locator alpha**x in increasing order
+   */
+  if(INDEX_OF[x1] < INDEX_OF[x2]){
+    z = x1; x1 = x2; x2 = z;
+    z = e1; e1 = e2; e2 = z;
+  }
+  loc[0] = apply_error(data,INDEX_OF[x1],e1,pad);
+  loc[1] = apply_error(data,INDEX_OF[x2],e2,pad);
+  return 2;
+}
@@ -247,10 +247,46 @@ void free_rs_int(void *rs);
 void encode_rs_8(unsigned char *data,unsigned char *parity,int pad);
 int decode_rs_8(unsigned char *data,int *eras_pos,int no_eras,int pad);
 
+/* SIMD tier used by encode_rs_8()/decode_rs_8(). The CPU is probed once,
+ * thread-safely, on first use; set_rs_8_mode() overrides the choice and
+ * returns 0 if the requested tier is not supported by this CPU.
+ */
+enum rs_8_mode {RS_8_AUTO=0,RS_8_PORT,RS_8_SSSE3,RS_8_AVX2};
+enum rs_8_mode get_rs_8_mode(void);
+int set_rs_8_mode(enum rs_8_mode mode);
+
 /* CCSDS standard (255,223) RS codec with dual-basis symbol representation */
 void encode_rs_ccsds(unsigned char *data,unsigned char *parity,int pad);
 int decode_rs_ccsds(unsigned char *data,int *eras_pos,int no_eras,int pad);
 
+/* Check-only verification of the (255,223) codes: the NN-NROOTS-pad data
+ * symbols and the NROOTS parity symbols may live in separate buffers and
+ * are not modified. Returns 0 if they form a codeword, nonzero otherwise.
+ */
+int check_rs_8(unsigned char *data,unsigned char *parity,int pad);
+int check_rs_ccsds(unsigned char *data,unsigned char *parity,int pad);
+
+/* Incremental parity update for the (255,223) codes: updates parity[] for
+ * data symbols pos..pos+len-1 having been XORed with delta[0..len), in
+ * time proportional to len. Returns 0 on success, -1 on bad arguments.
+ */
+int update_rs_8(unsigned char *parity,int pos,unsigned char *delta,int len,int pad);
+int update_rs_ccsds(unsigned char *parity,int pos,unsigned char *delta,int len,int pad);
+
+/* Batched versions of the (255,223) codecs over count blocks, all with the
+ * same pad. data[i] is the start of block i; parity[i] is its parity, or if
+ * parity is NULL the parity follows the data in each block. The check and
+ * decode functions store the per-block return value in result[i] if result
+ * is not NULL, and return the number of blocks that are not codewords
+ * (check) or could not be corrected (decode), or -1 on a bad pad.
+ */
+void encode_rs_8_batch(unsigned char **data,unsigned char **parity,int count,int pad);
+int check_rs_8_batch(unsigned char **data,unsigned char **parity,int count,int pad,int *result);
+int decode_rs_8_batch(unsigned char **data,int count,int pad,int *result);
+void encode_rs_ccsds_batch(unsigned char **data,unsigned char **parity,int count,int pad);
+int check_rs_ccsds_batch(unsigned char **data,unsigned char **parity,int count,int pad,int *result);
+int decode_rs_ccsds_batch(unsigned char **data,int count,int pad,int *result);
+
 /* Tables to map from conventional->dual (Taltab) and
  * dual->conventional (Tal1tab) bases
  */
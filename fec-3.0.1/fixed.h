@@ -19,10 +19,12 @@ static inline int mod255(int x){
 extern data_t CCSDS_alpha_to[];
 extern data_t CCSDS_index_of[];
 extern data_t CCSDS_poly[];
+extern data_t Rs_8_alpha_to2[]; /* CCSDS_alpha_to[] repeated twice, see rs_8_simd.c */
 
 #define MM 8
 #define NN 255
 #define ALPHA_TO CCSDS_alpha_to
+#define ALPHA_SUM(a,b) (Rs_8_alpha_to2[(a)+(b)])
 #define INDEX_OF CCSDS_index_of
 #define GENPOLY CCSDS_poly
 #define NROOTS 32
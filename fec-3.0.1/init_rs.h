@@ -31,12 +31,14 @@
   rs->nn = (1<<symsize)-1;
   rs->pad = pad;
 
-  rs->alpha_to = (data_t *)malloc(sizeof(data_t)*(rs->nn+1));
+  /* alpha_to2[] shares the allocation of alpha_to[] */
+  rs->alpha_to = (data_t *)malloc(sizeof(data_t)*(rs->nn+1+2*rs->nn));
   if(rs->alpha_to == NULL){
     free(rs);
     rs = NULL;
     goto done;
   }
+  rs->alpha_to2 = &rs->alpha_to[rs->nn+1];
   rs->index_of = (data_t *)malloc(sizeof(data_t)*(rs->nn+1));
   if(rs->index_of == NULL){
     free(rs->alpha_to);
@@ -52,6 +54,8 @@
   for(i=0;i<rs->nn;i++){
     rs->index_of[sr] = i;
     rs->alpha_to[i] = sr;
+    rs->alpha_to2[i] = sr;
+    rs->alpha_to2[i+rs->nn] = sr;
     sr <<= 1;
     if(sr & (1<<symsize))
       sr ^= gfpoly;
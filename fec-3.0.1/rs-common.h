@@ -8,6 +8,7 @@ struct rs {
   int mm;              /* Bits per symbol */
   int nn;              /* Symbols per block (= (1<<mm)-1) */
   data_t *alpha_to;     /* log lookup table */
+  data_t *alpha_to2;    /* alpha_to[] repeated twice, indexed by a sum of two logs */
   data_t *index_of;     /* Antilog lookup table */
   data_t *genpoly;      /* Generator polynomial */
   int nroots;     /* Number of generator roots = number of parity symbols */
@@ -0,0 +1,257 @@
+/* CCSDS (255,223) Reed-Solomon encoder and decoder kernels using AVX2
+ * The whole parity register fits in one 256-bit register, and syndromes
+ * and the Chien search work on 32 symbols per instruction
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include <immintrin.h>
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+#undef A0
+#define A0 (NN)
+
+/* Multiply each byte of v by the constant c */
+static inline __m128i gf_mul_128(__m128i v,data_t c){
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_load_si128((const __m128i *)&Rs_8_multab[c][0]);
+  __m128i hi = _mm_load_si128((const __m128i *)&Rs_8_multab[c][16]);
+
+  lo = _mm_shuffle_epi8(lo,_mm_and_si128(v,mask));
+  hi = _mm_shuffle_epi8(hi,_mm_and_si128(_mm_srli_epi64(v,4),mask));
+  return _mm_xor_si128(lo,hi);
+}
+
+static inline __m256i gf_mul_avx2(__m256i v,data_t c){
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)&Rs_8_multab[c][0]));
+  __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)&Rs_8_multab[c][16]));
+
+  lo = _mm256_shuffle_epi8(lo,_mm256_and_si256(v,mask));
+  hi = _mm256_shuffle_epi8(hi,_mm256_and_si256(_mm256_srli_epi64(v,4),mask));
+  return _mm256_xor_si256(lo,hi);
+}
+
+void encode_rs_8_avx2(data_t *data,data_t *parity,int pad){
+  __m256i reg = _mm256_setzero_si256();
+  int i;
+
+  for(i=0;i<NN-NROOTS-pad;i++){
+    data_t feedback = data[i] ^ (data_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(reg));
+    __m256i shifted;
+
+    /* Shift the register down one symbol and add feedback*g(x) */
+    shifted = _mm256_alignr_epi8(_mm256_permute2x128_si256(reg,reg,0x81),reg,1);
+    reg = _mm256_xor_si256(shifted,_mm256_load_si256((const __m256i *)Rs_8_enctab[feedback]));
+  }
+  _mm256_storeu_si256((__m256i *)parity,reg);
+}
+
+/* Apply a GF(2)-linear map, given as a split-nibble table, to each byte of v */
+static inline __m256i basis_avx2(__m256i v,const data_t *basis){
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&basis[0]));
+  __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&basis[16]));
+
+  lo = _mm256_shuffle_epi8(lo,_mm256_and_si256(v,mask));
+  hi = _mm256_shuffle_epi8(hi,_mm256_and_si256(_mm256_srli_epi64(v,4),mask));
+  return _mm256_xor_si256(lo,hi);
+}
+
+/* Split data[0..len) followed by parity[0..NROOTS) into 32 byte blocks,
+ * zero-extending the front so the last block is exactly the parity
+ */
+static inline int load_blocks_avx2(__m256i block[(NN+31)/32],const data_t *data,int len,
+				   const data_t *parity,const data_t *basis){
+  int nblock = 0;
+  int head = len & 31;
+  int i;
+
+  if(head != 0){
+    /* Leading zeros do not change the syndromes */
+    data_t first[32];
+
+    memset(first,0,sizeof(first));
+    memcpy(&first[32-head],data,head);
+    block[nblock++] = _mm256_loadu_si256((const __m256i *)first);
+  }
+  for(i=head;i<len;i+=32)
+    block[nblock++] = _mm256_loadu_si256((const __m256i *)&data[i]);
+  block[nblock++] = _mm256_loadu_si256((const __m256i *)parity);
+  if(basis != NULL){
+    for(i=0;i<nblock;i++)
+      block[i] = basis_avx2(block[i],basis);
+  }
+  return nblock;
+}
+
+/* Fold the 32 partial sums in v, the highest degree first, into one */
+static inline data_t fold_avx2(__m256i v,const data_t *r){
+  __m128i u;
+
+  u = _mm_xor_si128(gf_mul_128(_mm256_castsi256_si128(v),r[1]),_mm256_extracti128_si256(v,1));
+  u = _mm_xor_si128(gf_mul_128(u,r[2]),_mm_srli_si128(u,8));
+  u = _mm_xor_si128(gf_mul_128(u,r[3]),_mm_srli_si128(u,4));
+  u = _mm_xor_si128(gf_mul_128(u,r[4]),_mm_srli_si128(u,2));
+  u = _mm_xor_si128(gf_mul_128(u,r[5]),_mm_srli_si128(u,1));
+  return (data_t)_mm_cvtsi128_si32(u);
+}
+
+/* Evaluate the blocks at the four roots r_i..r_i+3 by Horner's rule with
+ * r**32, interleaved to hide the multiply latency, and fold each result
+ */
+static inline data_t syndromes4_avx2(const __m256i *block,int nblock,int i,data_t s[4]){
+  const data_t *r0 = Rs_8_synpow[i];
+  const data_t *r1 = Rs_8_synpow[i+1];
+  const data_t *r2 = Rs_8_synpow[i+2];
+  const data_t *r3 = Rs_8_synpow[i+3];
+  __m256i v0 = block[0];
+  __m256i v1 = block[0];
+  __m256i v2 = block[0];
+  __m256i v3 = block[0];
+  int b;
+
+  for(b=1;b<nblock;b++){
+    v0 = _mm256_xor_si256(gf_mul_avx2(v0,r0[0]),block[b]);
+    v1 = _mm256_xor_si256(gf_mul_avx2(v1,r1[0]),block[b]);
+    v2 = _mm256_xor_si256(gf_mul_avx2(v2,r2[0]),block[b]);
+    v3 = _mm256_xor_si256(gf_mul_avx2(v3,r3[0]),block[b]);
+  }
+  s[0] = fold_avx2(v0,r0);
+  s[1] = fold_avx2(v1,r1);
+  s[2] = fold_avx2(v2,r2);
+  s[3] = fold_avx2(v3,r3);
+  return s[0] | s[1] | s[2] | s[3];
+}
+
+/* Evaluate data[0..len) followed by parity[0..NROOTS) at the roots of g(x) */
+int syndromes_rs_8_avx2(const data_t *data,int len,const data_t *parity,data_t s[NROOTS]){
+  __m256i block[(NN+31)/32];
+  int nblock = load_blocks_avx2(block,data,len,parity,NULL);
+  int i;
+  data_t syn_error = 0;
+
+  for(i=0;i<NROOTS;i+=4)
+    syn_error |= syndromes4_avx2(block,nblock,i,&s[i]);
+  return syn_error;
+}
+
+int check_rs_8_avx2(const data_t *data,int len,const data_t *parity,const data_t *basis){
+  __m256i block[(NN+31)/32];
+  int nblock = load_blocks_avx2(block,data,len,parity,basis);
+  int i;
+  data_t s[4];
+
+  for(i=0;i<NROOTS;i+=4){
+    if(syndromes4_avx2(block,nblock,i,s) != 0)
+      return 1;
+  }
+  return 0;
+}
+
+void delta_rs_8_avx2(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis){
+  __m256i sum = _mm256_setzero_si256();
+  int j;
+
+  for(j=0;j<len;j++){
+    data_t d = delta[j];
+
+    if(basis != NULL)
+      d = basis[d & 15] ^ basis[16 + (d >> 4)];
+    if(d == 0)
+      continue; /* Unchanged symbol */
+    sum = _mm256_xor_si256(sum,gf_mul_avx2(_mm256_load_si256((const __m256i *)Rs_8_unittab[pos+j]),d));
+  }
+  _mm256_storeu_si256((__m256i *)acc,sum);
+}
+
+/* Chien search over the index-form lambda[], 32 field elements at a time.
+ * The odd terms of lambda(x) sum to x*lambda'(x), so the Forney
+ * denominators come from the same vectors, and omega(x) is evaluated
+ * alongside only in the blocks that contain roots
+ */
+int chien_forney_rs_8_avx2(const data_t lambda[NROOTS+1],int deg_lambda,const data_t omega[NROOTS+1],
+			    int deg_omega,data_t loc[NROOTS],data_t err[NROOTS]){
+  __m256i even_term[NROOTS],odd_term[NROOTS];
+  data_t even_step[NROOTS],odd_step[NROOTS];
+  data_t num[32] __attribute__((aligned(32)));
+  data_t den[32] __attribute__((aligned(32)));
+  int neven = 0,nodd = 0;
+  int count = 0;
+  int b,i,j,k;
+
+  for(j=1;j<=deg_lambda;j++){
+    __m256i t;
+
+    if(lambda[j] == A0)
+      continue;
+    t = gf_mul_avx2(_mm256_load_si256((const __m256i *)Rs_8_chientab[j]),ALPHA_TO[lambda[j]]);
+    if(j & 1){
+      odd_term[nodd] = t;
+      odd_step[nodd++] = Rs_8_chienstep[j][0];
+    } else {
+      even_term[neven] = t;
+      even_step[neven++] = Rs_8_chienstep[j][0];
+    }
+  }
+  for(b=0,i=1;i<=NN;b++,i+=32){
+    __m256i even = _mm256_set1_epi8(1); /* lambda[0] is always 0 */
+    __m256i odd = _mm256_setzero_si256();
+    __m256i omg;
+    unsigned int roots;
+
+    for(j=0;j<neven;j++){
+      even = _mm256_xor_si256(even,even_term[j]);
+      even_term[j] = gf_mul_avx2(even_term[j],even_step[j]);
+    }
+    for(j=0;j<nodd;j++){
+      odd = _mm256_xor_si256(odd,odd_term[j]);
+      odd_term[j] = gf_mul_avx2(odd_term[j],odd_step[j]);
+    }
+    roots = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_xor_si256(even,odd),_mm256_setzero_si256()));
+    if(i+31 > NN)
+      roots &= (1u << (NN-i+1)) - 1;
+    if(roots == 0)
+      continue;
+
+    /* omega(x) at the 32 points of this block */
+    omg = _mm256_set1_epi8((omega[0] == A0) ? 0 : ALPHA_TO[omega[0]]);
+    for(k=1;k<=deg_omega;k++){
+      if(omega[k] != A0)
+	omg = _mm256_xor_si256(omg,gf_mul_avx2(_mm256_load_si256((const __m256i *)Rs_8_chientab[k]),ALPHA_TO[MODNN(omega[k] + k*32*b)]));
+    }
+    _mm256_store_si256((__m256i *)num,omg);
+    _mm256_store_si256((__m256i *)den,odd);
+    while(roots != 0){
+      int n = __builtin_ctz(roots);
+      int r = i + n;
+
+      /* num1*num2/den = omega(x)*x**FCR/(x*lambda'(x)) at x = alpha**r */
+      loc[count] = MODNN(r*IPRIM + NN - 1);
+      err[count] = (num[n] == 0) ? 0 : ALPHA_TO[MODNN(INDEX_OF[num[n]] + r*FCR + NN - INDEX_OF[den[n]])];
+      /* If we've already found max possible roots,
+       * abort the search to save time
+       */
+      if(++count == deg_lambda)
+	return count;
+      roots &= roots - 1;
+    }
+  }
+  return count;
+}
+
+int decode_rs_8_avx2(data_t *data,int *eras_pos,int no_eras,int pad){
+  int retval;
+
+  if(pad < 0 || pad > 222){
+    return -1;
+  }
+
+#define SYNDROMES(s) syndromes_rs_8_avx2(data,NN-NROOTS-PAD,&data[NN-NROOTS-PAD],s)
+#define CHIEN_FORNEY(lambda,deg_lambda,omega,deg_omega,loc,err) chien_forney_rs_8_avx2(lambda,deg_lambda,omega,deg_omega,loc,err)
+#define FAST_DECODE(s,loc) fast_decode_rs_8(data,s,loc,PAD)
+#include "decode_rs.h"
+
+  return retval;
+}
@@ -0,0 +1,146 @@
+/* Runtime selection of the SIMD kernels for the CCSDS (255,223) codec
+ * The CPU is probed and the shared tables are built exactly once, under
+ * pthread_once(), before the kernel table is published to callers
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <pthread.h>
+#include <string.h>
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+data_t Rs_8_alpha_to2[2*NN] __attribute__((aligned(64)));
+data_t Rs_8_multab[256][32] __attribute__((aligned(32)));
+data_t Rs_8_tal1nib[32] __attribute__((aligned(32)));
+data_t Rs_8_enctab[256][NROOTS] __attribute__((aligned(32)));
+data_t Rs_8_unittab[NN-NROOTS][NROOTS] __attribute__((aligned(32)));
+data_t Rs_8_synpow[NROOTS][6];
+data_t Rs_8_chientab[NROOTS+1][32] __attribute__((aligned(32)));
+data_t Rs_8_chienstep[NROOTS+1][2];
+data_t Rs_8_quadtab[256];
+
+static const struct rs_8_kernels Port_kernels = {
+  RS_8_PORT,encode_rs_8_port,decode_rs_8_port,check_rs_8_port,delta_rs_8_port
+};
+#ifdef __x86_64__
+static const struct rs_8_kernels Ssse3_kernels = {
+  RS_8_SSSE3,encode_rs_8_ssse3,decode_rs_8_ssse3,check_rs_8_ssse3,delta_rs_8_ssse3
+};
+static const struct rs_8_kernels Avx2_kernels = {
+  RS_8_AVX2,encode_rs_8_avx2,decode_rs_8_avx2,check_rs_8_avx2,delta_rs_8_avx2
+};
+#endif
+
+static const struct rs_8_kernels *Kernels;
+static pthread_once_t Kernels_once = PTHREAD_ONCE_INIT;
+
+/* Multiply two field elements in polynomial form */
+static data_t gf_mul(data_t a,data_t b){
+  if(a == 0 || b == 0)
+    return 0;
+  return ALPHA_TO[MODNN(INDEX_OF[a] + INDEX_OF[b])];
+}
+
+static void init_tables(void){
+  int c,n,i,j,k;
+
+  for(i=0;i<NN;i++){
+    Rs_8_alpha_to2[i] = ALPHA_TO[i];
+    Rs_8_alpha_to2[i+NN] = ALPHA_TO[i];
+  }
+  for(c=0;c<256;c++){
+    for(n=0;n<16;n++){
+      Rs_8_multab[c][n] = gf_mul(c,n);
+      Rs_8_multab[c][16+n] = gf_mul(c,n << 4);
+    }
+    for(j=0;j<NROOTS;j++)
+      Rs_8_enctab[c][j] = gf_mul(c,ALPHA_TO[GENPOLY[NROOTS-1-j]]);
+  }
+  /* The last data symbol produces one encoder step with feedback 1; each
+   * earlier position is followed by one more step with zero input
+   */
+  memcpy(Rs_8_unittab[NN-NROOTS-1],Rs_8_enctab[1],NROOTS);
+  for(i=NN-NROOTS-2;i>=0;i--){
+    data_t feedback = Rs_8_unittab[i+1][0];
+
+    for(j=0;j<NROOTS-1;j++)
+      Rs_8_unittab[i][j] = Rs_8_unittab[i+1][j+1] ^ Rs_8_enctab[feedback][j];
+    Rs_8_unittab[i][NROOTS-1] = Rs_8_enctab[feedback][NROOTS-1];
+  }
+  for(i=0;i<NROOTS;i++){
+    for(k=0;k<6;k++)
+      Rs_8_synpow[i][k] = ALPHA_TO[MODNN((FCR+i)*PRIM*(32 >> k))];
+  }
+  for(j=0;j<=NROOTS;j++){
+    for(n=0;n<32;n++)
+      Rs_8_chientab[j][n] = ALPHA_TO[MODNN(j*(1+n))];
+    for(k=0;k<2;k++)
+      Rs_8_chienstep[j][k] = ALPHA_TO[MODNN(j*(32 >> k))];
+  }
+  for(c=0;c<256;c++)
+    Rs_8_quadtab[gf_mul(c,c) ^ c] = c;
+  for(n=0;n<16;n++){
+    Rs_8_tal1nib[n] = Tal1tab[n];
+    Rs_8_tal1nib[16+n] = Tal1tab[n << 4];
+  }
+}
+
+static const struct rs_8_kernels *best_kernels(void){
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    return &Avx2_kernels;
+  if(__builtin_cpu_supports("ssse3"))
+    return &Ssse3_kernels;
+#endif
+  return &Port_kernels;
+}
+
+static void probe_cpu(void){
+  init_tables();
+  __atomic_store_n(&Kernels,best_kernels(),__ATOMIC_RELEASE);
+}
+
+const struct rs_8_kernels *rs_8_kernels(void){
+  const struct rs_8_kernels *k = __atomic_load_n(&Kernels,__ATOMIC_ACQUIRE);
+
+  if(k == NULL){
+    pthread_once(&Kernels_once,probe_cpu);
+    k = __atomic_load_n(&Kernels,__ATOMIC_ACQUIRE);
+  }
+  return k;
+}
+
+enum rs_8_mode get_rs_8_mode(void){
+  return rs_8_kernels()->mode;
+}
+
+int set_rs_8_mode(enum rs_8_mode mode){
+  const struct rs_8_kernels *k;
+
+  rs_8_kernels(); /* Make sure the tables exist */
+  switch(mode){
+  case RS_8_AUTO:
+    k = best_kernels();
+    break;
+  case RS_8_PORT:
+    k = &Port_kernels;
+    break;
+#ifdef __x86_64__
+  case RS_8_SSSE3:
+    if(!__builtin_cpu_supports("ssse3"))
+      return 0;
+    k = &Ssse3_kernels;
+    break;
+  case RS_8_AVX2:
+    if(!__builtin_cpu_supports("avx2"))
+      return 0;
+    k = &Avx2_kernels;
+    break;
+#endif
+  default:
+    return 0;
+  }
+  __atomic_store_n(&Kernels,k,__ATOMIC_RELEASE);
+  return 1;
+}
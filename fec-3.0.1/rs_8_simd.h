@@ -0,0 +1,104 @@
+/* Internal interface between the CCSDS (255,223) codec entry points
+ * and the SIMD kernels that implement them. Must be included after fixed.h
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#ifndef _RS_8_SIMD_H_
+#define _RS_8_SIMD_H_
+
+#include "fec.h"
+
+/* Kernels selected at runtime for the current CPU */
+struct rs_8_kernels {
+  enum rs_8_mode mode;
+  void (*encode)(data_t *data,data_t *parity,int pad);
+  int (*decode)(data_t *data,int *eras_pos,int no_eras,int pad);
+  int (*check)(const data_t *data,int len,const data_t *parity,const data_t *basis);
+  void (*delta)(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis);
+};
+
+/* Returns the kernels for this CPU, probing it on first use */
+const struct rs_8_kernels *rs_8_kernels(void);
+
+/* Split-nibble product tables: Rs_8_multab[c][n] = c*n and
+ * Rs_8_multab[c][16+n] = c*(n<<4) for n = 0..15, so that c*x is
+ * Rs_8_multab[c][x & 15] ^ Rs_8_multab[c][16 + (x >> 4)]
+ */
+extern data_t Rs_8_multab[256][32];
+
+/* Split-nibble form of Tal1tab[], the GF(2)-linear dual->conventional
+ * basis map, for use as the basis argument of the check kernels
+ */
+extern data_t Rs_8_tal1nib[32];
+
+/* Encoder feedback table: Rs_8_enctab[f][j] = f * GENPOLY[NROOTS-1-j] in
+ * polynomial form, i.e. the value XORed into the shifted parity register
+ * when the feedback symbol is f
+ */
+extern data_t Rs_8_enctab[256][NROOTS];
+
+/* Parity of each unit data vector: Rs_8_unittab[j] is the (conventional
+ * basis) parity of a block that is 1 at data position j and 0 elsewhere.
+ * By linearity, changing data symbol j by d changes the parity by
+ * d * Rs_8_unittab[j]
+ */
+extern data_t Rs_8_unittab[NN-NROOTS][NROOTS];
+
+/* Powers of the syndrome roots r_i = alpha**((FCR+i)*PRIM) in polynomial
+ * form: Rs_8_synpow[i][k] = r_i**(32 >> k), k = 0..5
+ */
+extern data_t Rs_8_synpow[NROOTS][6];
+
+/* Chien search terms: Rs_8_chientab[j][l] = alpha**(j*(1+l)) and
+ * Rs_8_chienstep[j][k] = alpha**(j*(32 >> k)), k = 0..1
+ */
+extern data_t Rs_8_chientab[NROOTS+1][32];
+extern data_t Rs_8_chienstep[NROOTS+1][2];
+
+/* Solutions of z**2 + z = c: Rs_8_quadtab[c] is one root, the other being
+ * Rs_8_quadtab[c] ^ 1, or 0 if there is none (c != 0)
+ */
+extern data_t Rs_8_quadtab[256];
+
+/* Corrects data[] in place if the index-form syndromes s[] are those of
+ * exactly one or two errors outside the padding, storing their positions
+ * in loc[] and returning their number. Returns 0, leaving data[]
+ * untouched, if the general decoder is needed
+ */
+int fast_decode_rs_8(data_t *data,const data_t s[NROOTS],data_t loc[NROOTS],int pad);
+
+void encode_rs_8_port(data_t *data,data_t *parity,int pad);
+int decode_rs_8_port(data_t *data,int *eras_pos,int no_eras,int pad);
+
+/* The check kernels evaluate the syndromes of data[0..len) followed by
+ * parity[0..NROOTS) in place and return nonzero if any is nonzero. If
+ * basis is not NULL, every symbol is first mapped through that split-nibble
+ * linear map (e.g. Rs_8_tal1nib for dual-basis symbols)
+ */
+int check_rs_8_port(const data_t *data,int len,const data_t *parity,const data_t *basis);
+
+/* The delta kernels write to acc[] the conventional basis parity change
+ * caused by XORing delta[0..len) into the data symbols starting at full
+ * block position pos, mapping each delta symbol through basis if not NULL
+ */
+void delta_rs_8_port(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis);
+
+#ifdef __x86_64__
+void encode_rs_8_ssse3(data_t *data,data_t *parity,int pad);
+int decode_rs_8_ssse3(data_t *data,int *eras_pos,int no_eras,int pad);
+int syndromes_rs_8_ssse3(const data_t *data,int len,const data_t *parity,data_t s[NROOTS]);
+int check_rs_8_ssse3(const data_t *data,int len,const data_t *parity,const data_t *basis);
+void delta_rs_8_ssse3(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis);
+int chien_forney_rs_8_ssse3(const data_t lambda[NROOTS+1],int deg_lambda,const data_t omega[NROOTS+1],
+			    int deg_omega,data_t loc[NROOTS],data_t err[NROOTS]);
+
+void encode_rs_8_avx2(data_t *data,data_t *parity,int pad);
+int decode_rs_8_avx2(data_t *data,int *eras_pos,int no_eras,int pad);
+int syndromes_rs_8_avx2(const data_t *data,int len,const data_t *parity,data_t s[NROOTS]);
+int check_rs_8_avx2(const data_t *data,int len,const data_t *parity,const data_t *basis);
+void delta_rs_8_avx2(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis);
+int chien_forney_rs_8_avx2(const data_t lambda[NROOTS+1],int deg_lambda,const data_t omega[NROOTS+1],
+			    int deg_omega,data_t loc[NROOTS],data_t err[NROOTS]);
+#endif
+
+#endif /* _RS_8_SIMD_H_ */
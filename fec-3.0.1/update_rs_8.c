@@ -0,0 +1,61 @@
+/* Incremental parity update for the CCSDS (255,223) code
+ * The code is linear, so changing data symbols by a XOR delta changes the
+ * parity by the parity of the delta alone; only the changed symbols are
+ * processed
+ *
+ * May be used under the terms of the GNU Lesser General Public License (LGPL)
+ */
+#include <string.h>
+#include "fixed.h"
+#include "rs_8_simd.h"
+
+int update_rs_8(data_t *parity,int pos,data_t *delta,int len,int pad){
+  data_t acc[NROOTS];
+  int i;
+
+  if(pad < 0 || pad > 222 || pos < 0 || len < 0 || pos + len > NN-NROOTS-pad){
+    return -1;
+  }
+  rs_8_kernels()->delta(acc,pad+pos,delta,len,NULL);
+  for(i=0;i<NROOTS;i++)
+    parity[i] ^= acc[i];
+  return 0;
+}
+
+int update_rs_ccsds(data_t *parity,int pos,data_t *delta,int len,int pad){
+  const struct rs_8_kernels *k;
+  data_t acc[NROOTS];
+  int i;
+
+  if(pad < 0 || pad > 222 || pos < 0 || len < 0 || pos + len > NN-NROOTS-pad){
+    return -1;
+  }
+  k = rs_8_kernels(); /* Builds Rs_8_tal1nib */
+  k->delta(acc,pad+pos,delta,len,Rs_8_tal1nib);
+
+  /* Convert parity change from conventional to dual basis */
+  for(i=0;i<NROOTS;i++)
+    parity[i] ^= Taltab[acc[i]];
+  return 0;
+}
+
+/* Portable C version */
+void delta_rs_8_port(data_t acc[NROOTS],int pos,const data_t *delta,int len,const data_t *basis){
+  int i,j;
+
+  for(i=0;i<NROOTS;i++)
+    acc[i] = 0;
+  for(j=0;j<len;j++){
+    data_t d = delta[j];
+    const data_t *unit = Rs_8_unittab[pos+j];
+
+    if(basis != NULL)
+      d = basis[d & 15] ^ basis[16 + (d >> 4)];
+    if(d == 0)
+      continue; /* Unchanged symbol */
+    for(i=0;i<NROOTS;i++){
+      if(unit[i] != 0)
+	acc[i] ^= ALPHA_SUM(INDEX_OF[d],INDEX_OF[unit[i]]);
+    }
+  }
+}
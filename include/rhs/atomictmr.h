@@ -0,0 +1,465 @@
+/**
+ * @file rhs/atomictmr.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Lock-free redundant variable.
+ */
+
+#ifndef _RHS_ATOMICTMR_H_
+#define _RHS_ATOMICTMR_H_
+
+#include "error.h"
+#include "registry.h"
+#include "telemetry.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace rhs {
+
+/**
+ * Word holding the version and value of one copy of an atomic_tmr.
+ * Values of up to 32 bits share a 64-bit word with a 32-bit version.
+ * @tparam Size Size of the value in bytes.
+ */
+template<size_t Size>
+struct atomic_tmr_word {
+	typedef uint64_t type;         ///< Word.
+	typedef uint32_t version_type; ///< Version, the high half.
+	typedef uint32_t bits_type;    ///< Value, the low half.
+	
+	static constexpr bool supported = (Size <= sizeof(bits_type)) && std::atomic<type>::is_always_lock_free;
+	
+	/**
+	 * Atomic word.
+	 */
+	class cell {
+		public:
+			/** Initial word, before the cell is shared. */
+			void init(type w) {
+				word.store(w, std::memory_order_relaxed);
+			}
+			
+			/** Read the word. */
+			type load() const {
+				return word.load();
+			}
+			
+			/** Replace the word if it is expected, else read it into expected. */
+			bool compare_exchange(type& expected, type desired) {
+				return word.compare_exchange_strong(expected, desired);
+			}
+		
+		private:
+			std::atomic<type> word; ///< Version and value.
+	};
+};
+
+#if defined(__x86_64__) && defined(__SIZEOF_INT128__)
+/**
+ * Word holding the version and value of one copy of an atomic_tmr.
+ * Values of 5 to 8 bytes, e.g. pointers and 64-bit counters, share a 128-bit
+ * word with a 64-bit version, updated with cmpxchg16b.  Loads are a
+ * cmpxchg16b too, so they take the cache line exclusively.
+ * @tparam Size Size of the value in bytes.
+ */
+template<>
+struct atomic_tmr_word<8> {
+	typedef unsigned __int128 type; ///< Word.
+	typedef uint64_t version_type;  ///< Version, the high half.
+	typedef uint64_t bits_type;     ///< Value, the low half.
+	
+	static constexpr bool supported = true;
+	
+	/**
+	 * Atomic word.
+	 */
+	class alignas(16) cell {
+		public:
+			/** Initial word, before the cell is shared. */
+			void init(type w) {
+				word = w;
+			}
+			
+			/** Read the word. */
+			type load() const {
+				type expected = 0;
+				const_cast<cell*>(this)->compare_exchange(expected, 0);
+				return expected;
+			}
+			
+			/** Replace the word if it is expected, else read it into expected. */
+			__attribute__((target("cx16"))) bool compare_exchange(type& expected, type desired) {
+				type prev = __sync_val_compare_and_swap(&word, expected, desired);
+				bool ret = (prev == expected);
+				expected = prev;
+				return ret;
+			}
+		
+		private:
+			type word; ///< Version and value, only accessed with cmpxchg16b.
+	};
+};
+
+template<> struct atomic_tmr_word<5> : atomic_tmr_word<8> {};
+template<> struct atomic_tmr_word<6> : atomic_tmr_word<8> {};
+template<> struct atomic_tmr_word<7> : atomic_tmr_word<8> {};
+#endif
+
+/**
+ * Redundant variable shared between threads, without locks.
+ *
+ * Each copy is an atomic word holding the value and a version: 64 bits with
+ * a 32-bit version for values of up to 32 bits, and on x86_64 128 bits with
+ * a 64-bit version for values of up to 64 bits, e.g. pointers and 64-bit
+ * counters.  Every modification is a compare-and-swap of copy 0 from the
+ * current word to the next version, which is where it takes effect,
+ * followed by the same compare-and-swap on the other copies in order.  So
+ * between modifications every copy holds the same word, and while one is in
+ * progress copy 0 is exactly one version ahead of the last copy.
+ *
+ * Every operation first settles the copies: a modification in progress is
+ * completed on its behalf, and otherwise any copy that differs from the
+ * majority is an upset and is corrected.  Repairs are compare-and-swaps from
+ * the word that was read, so they fail if the copy changed since.  A copy
+ * that was read with a newer version than the majority is only repaired if
+ * copy 0 has not changed since it was read, i.e. if no modification has
+ * started in the meantime; otherwise the copies are read again.  So a
+ * repair never moves a copy back to an older version than it was given by a
+ * modification, as long as versions do not wrap around during one
+ * settlement (2^32 modifications for 32-bit versions).  verify() and
+ * correct() may therefore run at any time, e.g. from a scrubber.
+ *
+ * load() only reads unless a modification is in progress or an upset is
+ * found.  All operations are sequentially consistent.  An upset in the
+ * version bits alone does not change the value and is harmless.  An upset
+ * of copy 0 while a modification is in progress is not detected, since copy
+ * 0 alone holds the new word until the other copies are advanced.
+ * @tparam T Integral, enum or pointer type, or another type with unique
+ * object representations, of at most 32 bits, or 64 bits on x86_64.
+ * @tparam N Number of redundant copies.
+ * @tparam Reg Registry policy, unregistered or registered.
+ */
+template<typename T, unsigned int N = 3, typename Reg = unregistered>
+class atomic_tmr : private Reg {
+	typedef atomic_tmr_word<sizeof(T)> word;
+	typedef typename word::type word_type;
+	typedef typename word::version_type version_type;
+	typedef typename word::bits_type bits_type;
+	
+	static_assert(std::has_unique_object_representations_v<T>, "Values are compared bitwise and must have no padding");
+	static_assert(word::supported, "Values must fit in a lock-free word next to the version");
+	static_assert(N >= 3, "Voting needs at least three copies");
+	
+	public:
+		/**
+		 * Constructor.
+		 * @param value Initial value.
+		 */
+		atomic_tmr(T value = T()) {  // cppcheck-suppress noExplicitConstructor
+			const word_type w = pack(0, value);
+			for(auto& r : copies){
+				r.init(w);
+			}
+			Reg::enroll(this);
+		}
+		
+		atomic_tmr(const atomic_tmr&) = delete;
+		atomic_tmr& operator=(const atomic_tmr&) = delete;
+		
+		/**
+		 * Destructor.
+		 */
+		~atomic_tmr() {
+			Reg::leave();
+		}
+		
+		/**
+		 * Read the value.
+		 * @return Voted value.
+		 */
+		T load() const {
+			return unpack(settle());
+		}
+		
+		operator T() const {
+			return load();
+		}
+		
+		/**
+		 * Write the value.
+		 * @param value New value.
+		 */
+		void store(T value) {
+			modify([value](T) { return value; });
+		}
+		
+		atomic_tmr& operator=(T value) {
+			store(value);
+			return *this;
+		}
+		
+		/**
+		 * Write the value.
+		 * @param value New value.
+		 * @return Previous value.
+		 */
+		T exchange(T value) {
+			return modify([value](T) { return value; });
+		}
+		
+		/**
+		 * Add to the value.
+		 * @param arg Addend.
+		 * @return Previous value.
+		 */
+		template<typename U = T, typename = std::enable_if_t<std::is_integral<U>::value>>
+		T fetch_add(T arg) {
+			return modify([arg](T v) { return static_cast<T>(v + arg); });
+		}
+		
+		/**
+		 * Subtract from the value.
+		 * @param arg Subtrahend.
+		 * @return Previous value.
+		 */
+		template<typename U = T, typename = std::enable_if_t<std::is_integral<U>::value>>
+		T fetch_sub(T arg) {
+			return modify([arg](T v) { return static_cast<T>(v - arg); });
+		}
+		
+		/**
+		 * Replace the value if it is equal to expected.
+		 * @param expected Expected value, receives the current value on failure.
+		 * @param desired New value.
+		 * @return true if the value was replaced.
+		 */
+		bool compare_exchange_strong(T& expected, T desired) {
+			for(;;){
+				word_type cur = settle();
+				T value = unpack(cur);
+				if(memcmp(&value, &expected, sizeof(T)) != 0){
+					expected = value;
+					return false;
+				}
+				if(advance(cur, desired)){
+					return true;
+				}
+			}
+		}
+		
+		/**
+		 * Replace the value if it is equal to expected.
+		 * Never fails spuriously, see compare_exchange_strong().
+		 * @param expected Expected value, receives the current value on failure.
+		 * @param desired New value.
+		 * @return true if the value was replaced.
+		 */
+		bool compare_exchange_weak(T& expected, T desired) {
+			return compare_exchange_strong(expected, desired);
+		}
+		
+		/**
+		 * Flip bits of one copy, as an upset would.
+		 * @param i Copy index.
+		 * @param mask Bits to flip, the value is in the low bits and the
+		 * version above it.
+		 * @note For testing only.
+		 */
+		void upset(unsigned int i, word_type mask) {
+			word_type w = copies[i].load();
+			while(!copies[i].compare_exchange(w, w ^ mask));
+		}
+		
+		/**
+		 * Verify the integrity of the variable.
+		 * A modification in progress is reported as not verified.
+		 * @return RHS_EOK if every copy matches.
+		 */
+		rhs_error_t verify() {
+			const word_type first = copies[0].load();
+			for(unsigned int i = 1; i < N; ++i){
+				if(copies[i].load() != first){
+					report(EVENT_NOTVERIFIED, this);
+					return RHS_ENOTVERIFIED;
+				}
+			}
+			return RHS_EOK;
+		}
+		
+		/**
+		 * Correct errors in the variable.
+		 * @return RHS_EOK if the variable is corrected.
+		 */
+		rhs_error_t correct() {
+			bool decided = true;
+			settle(&decided);
+			return decided ? RHS_EOK : RHS_ENOTCORRECTED;
+		}
+		
+		/**
+		 * Verify the integrity of the variable and correct errors.
+		 * @return RHS_EOK if the variable is verified or corrected.
+		 */
+		rhs_error_t verifyAndCorrect() {
+			rhs_error_t ret = verify();
+			if(ret == RHS_ENOTVERIFIED){
+				ret = correct();
+			}
+			return ret;
+		}
+	
+	private:
+		/**
+		 * Word holding a version and a value.
+		 * @param version Version.
+		 * @param value Value.
+		 * @return Word.
+		 */
+		static word_type pack(version_type version, T value) {
+			bits_type bits = 0;
+			memcpy(&bits, &value, sizeof(T));
+			return (static_cast<word_type>(version) << (8*sizeof(bits_type))) | bits;
+		}
+		
+		/**
+		 * Value of a word.
+		 * @param w Word.
+		 * @return Value.
+		 */
+		static T unpack(word_type w) {
+			bits_type bits = static_cast<bits_type>(w);
+			T value;
+			memcpy(&value, &bits, sizeof(T));
+			return value;
+		}
+		
+		/**
+		 * Version of a word.
+		 * @param w Word.
+		 * @return Version.
+		 */
+		static version_type version(word_type w) {
+			return static_cast<version_type>(w >> (8*sizeof(bits_type)));
+		}
+		
+		/**
+		 * Complete any modification in progress and correct upsets.
+		 * @param decided Set to false if the copies had no majority, in which
+		 * case copy 0 is kept.
+		 * @return Current word, held by every copy when it was read.
+		 */
+		word_type settle(bool* decided = nullptr) const {
+			for(;;){
+				word_type w[N];
+				for(unsigned int i = 0; i < N; ++i){
+					w[i] = copies[i].load();
+				}
+				
+				word_type target = w[0];
+				bool upset = false;
+				if(static_cast<version_type>(version(w[0]) - version(w[N-1])) != 1){
+					// No modification in progress, vote
+					unsigned int most = 0;
+					for(unsigned int c = 0; c < N; ++c){
+						unsigned int count = 0;
+						for(unsigned int i = 0; i < N; ++i){
+							count += (w[i] == w[c]);
+						}
+						if(count > most){
+							most = count;
+							target = w[c];
+						}
+					}
+					if(most == N){
+						return target;
+					}
+					upset = true;
+					if(most <= N/2){
+						target = w[0];
+						report(EVENT_NOTCORRECTED, this);
+						if(decided != nullptr){
+							*decided = false;
+						}
+					}
+				}
+				
+				bool settled = true;
+				int repaired = 0;
+				for(unsigned int i = 0; i < N; ++i){
+					if(w[i] == target){
+						continue;
+					}
+					if(newer(w[i], target) && copies[0].load() != w[0]){
+						// Read during a modification, not an upset
+						settled = false;
+						break;
+					}
+					word_type expected = w[i];
+					if(copies[i].compare_exchange(expected, target)){
+						++repaired;
+					}else{
+						settled = false;
+					}
+				}
+				if(upset && repaired > 0){
+					report(EVENT_CORRECTED, this, -1, repaired);
+				}
+				if(settled){
+					return target;
+				}
+			}
+		}
+		
+		/**
+		 * Compare the versions of two words.
+		 * @param a Word.
+		 * @param b Word.
+		 * @return true if a has a newer version than b.
+		 */
+		static bool newer(word_type a, word_type b) {
+			return static_cast<std::make_signed_t<version_type>>(version(a) - version(b)) > 0;
+		}
+		
+		/**
+		 * Start and complete a modification.
+		 * @param cur Current word, from settle().
+		 * @param value New value.
+		 * @return false if another modification came first.
+		 */
+		bool advance(word_type cur, T value) {
+			const word_type next = pack(version(cur) + 1, value);
+			word_type expected = cur;
+			if(!copies[0].compare_exchange(expected, next)){
+				return false;
+			}
+			for(unsigned int i = 1; i < N; ++i){
+				expected = cur;
+				copies[i].compare_exchange(expected, next);
+			}
+			return true;
+		}
+		
+		/**
+		 * Apply a function to the value.
+		 * @param f Function from the current value to the new value.
+		 * @return Previous value.
+		 */
+		template<typename F>
+		T modify(F f) {
+			for(;;){
+				word_type cur = settle();
+				T value = unpack(cur);
+				if(advance(cur, f(value))){
+					return value;
+				}
+			}
+		}
+		
+		mutable typename word::cell copies[N]; ///< Version and value of each copy.
+};
+
+} // namespace rhs
+
+#endif // _RHS_ATOMICTMR_H_
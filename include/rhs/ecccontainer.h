@@ -0,0 +1,469 @@
+/**
+ * @file rhs/ecccontainer.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Arrays with error correction per codeword.
+ */
+
+#ifndef _RHS_ECCCONTAINER_H_
+#define _RHS_ECCCONTAINER_H_
+
+#include "edacmemory.h"
+#include <array>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace rhs {
+
+/**
+ * Elements protected by a single codeword, or by as few codewords as
+ * possible if one element does not fit in a codeword.
+ * @tparam T Type of the elements.
+ * @tparam Codec Symbol representation, see reedsolomon.
+ */
+template<typename T, typename Codec=conventional_codec>
+class ecc_chunk {
+	public:
+		enum {
+			_data_size = Codec::NN - Codec::NROOTS,
+			ELEMENTS = (sizeof(T) < _data_size) ? (_data_size / sizeof(T)) : 1, ///< Elements per chunk.
+		};
+		static_assert(std::is_trivially_copyable<T>::value, "Elements must be trivially copyable");
+
+		/**
+		 * Constructor.
+		 */
+		ecc_chunk() :
+			data{},
+			ecc(data)
+		{}
+
+		/**
+		 * Element of the chunk, without verification.
+		 * @param i Index in the chunk.
+		 * @return Reference to the element.
+		 */
+		const T& operator[](size_t i) const {
+			return data[i];
+		}
+
+		/**
+		 * Element of the chunk, without verification.
+		 * @param i Index in the chunk.
+		 * @return Reference to the element.
+		 */
+		T& operator[](size_t i) {
+			return data[i];
+		}
+
+		/**
+		 * Update the ECC for one element from its previous value.
+		 * @param i Index in the chunk.
+		 * @param old Value of the element before the change.
+		 */
+		void update(size_t i, const T& old) {
+			ecc.update(data, i*sizeof(T), sizeof(T), &old);
+		}
+
+		/**
+		 * Update the ECC for the whole chunk.
+		 */
+		void update() {
+			ecc.calculate(data);
+		}
+
+		/**
+		 * Verify the integrity of the chunk.
+		 * @return Error code, see reedsolomon::verify().
+		 */
+		rhs_error_t verify() const {
+			return ecc.verify(data);
+		}
+
+		/**
+		 * Correct errors in the chunk.
+		 * @return Error code, see reedsolomon::correct().
+		 */
+		rhs_error_t correct() {
+			return ecc.correct(data);
+		}
+
+		/**
+		 * Verify the integrity of the chunk and correct errors.
+		 * @return Error code, see reedsolomon::correct().
+		 */
+		rhs_error_t verifyAndCorrect() {
+			rhs_error_t ret = verify();
+			if(ret == RHS_ENOTVERIFIED){
+				ret = correct();
+			}
+			return ret;
+		}
+
+	private:
+		typedef std::array<T, ELEMENTS> block_type;                 ///< Protected elements.
+		typedef reedsolomon<block_type, block_type, Codec> ECC;    ///< ECC type
+
+		block_type data; ///< Elements being protected.
+		ECC ecc;         ///< ECC state.
+};
+
+/**
+ * Sequence of elements split into independently protected chunks.
+ * Element access verifies and corrects only the chunk holding the element,
+ * and iterators verify each chunk once as they enter it.  As with ecc_obj,
+ * element access and iterators are read-only, and elements are written with
+ * set(), which updates the ECC.
+ * @tparam T Type of the elements.
+ * @tparam Codec Symbol representation, see reedsolomon.
+ * @tparam Storage Container of ecc_chunk.
+ */
+template<typename T, typename Codec, typename Storage>
+class ecc_sequence {
+	public:
+		typedef ecc_chunk<T, Codec> chunk_type; ///< Chunk type.
+		enum {
+			CHUNK_ELEMENTS = chunk_type::ELEMENTS, ///< Elements per chunk.
+		};
+
+		/**
+		 * Iterator which verifies each chunk once on entering it.
+		 * @tparam Seq Sequence type, const for a const_iterator.
+		 * @tparam Ref Reference type.
+		 */
+		template<typename Seq, typename Ref>
+		class basic_iterator {
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef T value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef typename std::remove_reference<Ref>::type* pointer;
+				typedef Ref reference;
+
+				basic_iterator() = default;
+
+				/**
+				 * Constructor.
+				 * @param seq Sequence to iterate.
+				 * @param index Index of the first element.
+				 */
+				basic_iterator(Seq* seq, size_t index) :
+					seq(seq),
+					index(index)
+				{}
+
+				/**
+				 * Dereference operator.
+				 * @return Reference to the element.
+				 */
+				reference operator*() const {
+					size_t c = index / CHUNK_ELEMENTS;
+					if(c != checked){
+						seq->check(c);
+						checked = c;
+					}
+					return seq->chunks[c][index % CHUNK_ELEMENTS];
+				}
+
+				/**
+				 * Arrow operator.
+				 * @return Pointer to the element.
+				 */
+				pointer operator->() const {
+					return &**this;
+				}
+
+				basic_iterator& operator++() {
+					++index;
+					return *this;
+				}
+
+				basic_iterator operator++(int) {
+					basic_iterator ret = *this;
+					++index;
+					return ret;
+				}
+
+				bool operator==(const basic_iterator& rhs) const {
+					return index == rhs.index;
+				}
+
+				bool operator!=(const basic_iterator& rhs) const {
+					return index != rhs.index;
+				}
+
+			private:
+				Seq* seq = nullptr;                          ///< Sequence being iterated.
+				size_t index = 0;                            ///< Current element.
+				mutable size_t checked = static_cast<size_t>(-1); ///< Last chunk verified.
+		};
+
+		typedef basic_iterator<ecc_sequence, const T&> iterator;             ///< Iterator, corrects each chunk.
+		typedef basic_iterator<const ecc_sequence, const T&> const_iterator; ///< Const iterator.
+
+		/**
+		 * Element access.
+		 * @param i Index of the element.
+		 * @return Reference to the element.
+		 */
+		const T& operator[](size_t i) const {
+			chunks[i / CHUNK_ELEMENTS].verify();
+			return chunks[i / CHUNK_ELEMENTS][i % CHUNK_ELEMENTS];
+		}
+
+		/**
+		 * Element access, correcting the chunk holding the element.
+		 * @param i Index of the element.
+		 * @return Reference to the element.
+		 */
+		const T& operator[](size_t i) {
+			chunks[i / CHUNK_ELEMENTS].verifyAndCorrect();
+			return chunks[i / CHUNK_ELEMENTS][i % CHUNK_ELEMENTS];
+		}
+
+		/**
+		 * Set an element.
+		 * Only the element's bytes are processed to update the ECC.
+		 * @param i Index of the element.
+		 * @param value New value.
+		 */
+		void set(size_t i, const T& value) {
+			chunk_type& c = chunks[i / CHUNK_ELEMENTS];
+			c.verifyAndCorrect();
+			T old = c[i % CHUNK_ELEMENTS];
+			c[i % CHUNK_ELEMENTS] = value;
+			c.update(i % CHUNK_ELEMENTS, old);
+		}
+
+		/**
+		 * Update the ECC for one element.
+		 * @note This must be called after the element is modified other than with set().
+		 * @param i Index of the element.
+		 */
+		void update(size_t i) {
+			chunks[i / CHUNK_ELEMENTS].update();
+		}
+
+		/**
+		 * Update the ECC for every element.
+		 */
+		void update() {
+			for(auto& c : chunks){
+				c.update();
+			}
+		}
+
+		/**
+		 * Verify the integrity of every element.
+		 * @return Error code.
+		 * @retval RHS_EOK if every checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if any checksum does not verify.
+		 */
+		rhs_error_t verify() const {
+			rhs_error_t ret = RHS_EOK;
+			for(const auto& c : chunks){
+				if(c.verify() != RHS_EOK){
+					ret = RHS_ENOTVERIFIED;
+				}
+			}
+			return ret;
+		}
+
+		/**
+		 * Correct errors in every element.
+		 * @return Error code.
+		 * @retval RHS_EOK if every checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if any checksum does not verify.
+		 * @retval RHS_ENOTCORRECTED if correction fails.
+		 */
+		rhs_error_t correct() {
+			rhs_error_t ret = RHS_EOK;
+			for(auto& c : chunks){
+				rhs_error_t r = c.correct();
+				if(r == RHS_ENOTCORRECTED || ret == RHS_EOK){
+					ret = r;
+				}
+			}
+			return ret;
+		}
+
+		/**
+		 * Number of elements.
+		 * @return Element count.
+		 */
+		size_t size() const {
+			return count;
+		}
+
+		/**
+		 * Check for elements.
+		 * @return true if there are no elements.
+		 */
+		bool empty() const {
+			return count == 0;
+		}
+
+		iterator begin() {
+			return iterator(this, 0);
+		}
+
+		iterator end() {
+			return iterator(this, count);
+		}
+
+		const_iterator begin() const {
+			return const_iterator(this, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(this, count);
+		}
+
+		const_iterator cbegin() const {
+			return begin();
+		}
+
+		const_iterator cend() const {
+			return end();
+		}
+
+	protected:
+		/**
+		 * Constructor.
+		 * @param count Number of elements.
+		 */
+		explicit ecc_sequence(size_t count) :
+			count(count)
+		{}
+
+		/**
+		 * Number of chunks needed for some elements.
+		 * @param n Number of elements.
+		 * @return Chunk count.
+		 */
+		static constexpr size_t chunks_for(size_t n) {
+			return (n + CHUNK_ELEMENTS - 1) / CHUNK_ELEMENTS;
+		}
+
+		Storage chunks; ///< Protected chunks.
+		size_t count;   ///< Number of elements.
+
+	private:
+		/**
+		 * Verify a chunk for a const iterator.
+		 * @param c Chunk index.
+		 */
+		void check(size_t c) const {
+			chunks[c].verify();
+		}
+
+		/**
+		 * Verify and correct a chunk for an iterator.
+		 * @param c Chunk index.
+		 */
+		void check(size_t c) {
+			chunks[c].verifyAndCorrect();
+		}
+};
+
+/**
+ * Fixed size array with error correction per codeword.
+ * @tparam T Type of the elements.
+ * @tparam N Number of elements.
+ * @tparam Codec Symbol representation, see reedsolomon.
+ */
+template<typename T, size_t N, typename Codec=conventional_codec>
+class ecc_array : public ecc_sequence<T, Codec, std::array<ecc_chunk<T, Codec>, (N + ecc_chunk<T, Codec>::ELEMENTS - 1) / ecc_chunk<T, Codec>::ELEMENTS>> {
+	public:
+		/**
+		 * Constructor, value-initializes every element.
+		 */
+		ecc_array() :
+			ecc_array::ecc_sequence(N)
+		{}
+};
+
+/**
+ * Growable array with error correction per codeword.
+ * @tparam T Type of the elements.
+ * @tparam Codec Symbol representation, see reedsolomon.
+ */
+template<typename T, typename Codec=conventional_codec>
+class ecc_vector : public ecc_sequence<T, Codec, std::vector<ecc_chunk<T, Codec>>> {
+	public:
+		/**
+		 * Constructor.
+		 * @param n Number of value-initialized elements.
+		 */
+		explicit ecc_vector(size_t n = 0) :
+			ecc_vector::ecc_sequence(0)
+		{
+			resize(n);
+		}
+
+		/**
+		 * Append an element.
+		 * @param value Element to append.
+		 */
+		void push_back(const T& value) {
+			if(this->count % this->CHUNK_ELEMENTS == 0){
+				this->chunks.emplace_back();
+			}
+			++this->count;
+			this->set(this->count - 1, value);
+		}
+
+		/**
+		 * Remove the last element.
+		 */
+		void pop_back() {
+			this->set(this->count - 1, T{});
+			--this->count;
+			this->chunks.resize(this->chunks_for(this->count));
+		}
+
+		/**
+		 * Change the number of elements.
+		 * New elements are value-initialized.  Elements past the end of the
+		 * last chunk are kept value-initialized, so whole chunks are added
+		 * and removed without updating the ECC of each element.
+		 * @param n Number of elements.
+		 */
+		void resize(size_t n) {
+			size_t end = this->chunks_for(n) * this->CHUNK_ELEMENTS;
+			for(size_t i = n; i < this->count && i < end; ++i){
+				this->set(i, T{});
+			}
+			this->chunks.resize(this->chunks_for(n));
+			this->count = n;
+		}
+
+		/**
+		 * Reserve storage.
+		 * @param n Number of elements.
+		 */
+		void reserve(size_t n) {
+			this->chunks.reserve(this->chunks_for(n));
+		}
+
+		/**
+		 * Number of elements that fit in the allocated storage.
+		 * @return Element count.
+		 */
+		size_t capacity() const {
+			return this->chunks.capacity() * this->CHUNK_ELEMENTS;
+		}
+
+		/**
+		 * Remove every element.
+		 */
+		void clear() {
+			this->chunks.clear();
+			this->count = 0;
+		}
+};
+
+} // namespace rhs
+
+#endif // _RHS_ECCCONTAINER_H_
@@ -0,0 +1,512 @@
+/**
+ * @file rhs/eccregion.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Memory region with error correction maintained through write faults.
+ */
+
+#ifndef _RHS_ECCREGION_H_
+#define _RHS_ECCREGION_H_
+
+#include "edacmemory.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rhs {
+
+/**
+ * Page-granular write tracking.
+ * The pages of the region are mapped read-only.  The first write to a page
+ * faults; the SIGSEGV handler marks the page dirty and makes it writable,
+ * and the write is restarted.  lock_dirty() write-protects a dirty page again.
+ * Faults outside every region are passed to the previous handler.
+ *
+ * The region is a memfd mapped twice, and repair() writes through the second,
+ * always writable mapping, so the pages stay protected while they are
+ * repaired.  A page is locked while it is encoded, repaired or unprotected;
+ * a write from another thread meanwhile faults and waits in the handler
+ * until the page is unlocked.  Unlocking a page starts a new generation, so
+ * a repair decoded from a page that was written, encoded or repaired since
+ * it was read is refused.
+ *
+ * The handler spins on locked pages and calls mprotect(), neither of which
+ * POSIX guarantees to be async-signal-safe; both are safe on Linux, where
+ * mprotect() is a plain system call.  Writes by the kernel, e.g. read() or
+ * recv() into the region, do not fault but fail with EFAULT on a clean page,
+ * so such buffers must be written by the program first, or filled through a
+ * copy.
+ *
+ * At most MAX_REGIONS regions can be live at once, since the handler looks
+ * them up in a fixed table.
+ */
+class page_tracker {
+	public:
+		enum {
+			MAX_REGIONS = 64, ///< Maximum number of live regions.
+		};
+		
+		enum {
+			CLEAN = 0,      ///< Page matches its ECC and is write-protected.
+			DIRTY = 1,      ///< Page was written and is writable.
+			BUSY = 2,       ///< Page is locked, writers wait.
+			STATE_MASK = 3, ///< State bits of a page, the generation is kept above them.
+			GENERATION = 4, ///< Increment of the generation.
+		};
+		
+		/**
+		 * Constructor.
+		 * @param size Size of the region in bytes, rounded up to whole pages.
+		 * @throw std::bad_alloc if the region cannot be mapped, or
+		 * MAX_REGIONS regions are already live.
+		 */
+		explicit page_tracker(size_t size) :
+			page_size(sysconf(_SC_PAGESIZE)),
+			pages((size + page_size - 1) / page_size),
+			state(new std::atomic<uint32_t>[pages])
+		{
+			for(size_t i = 0; i < pages; ++i){
+				state[i] = CLEAN;
+			}
+			if(!map()){
+				throw std::bad_alloc();
+			}
+			install();
+			// base is set before the region is published, the release pairs
+			// with the acquire in the handler
+			for(auto& slot : registry()){
+				page_tracker* expected = nullptr;
+				if(slot.compare_exchange_strong(expected, this, std::memory_order_release, std::memory_order_relaxed)){
+					return;
+				}
+			}
+			// No free slot, writes could not be tracked
+			unmap();
+			throw std::bad_alloc();
+		}
+		
+		page_tracker(const page_tracker&) = delete;
+		page_tracker& operator=(const page_tracker&) = delete;
+		
+		/**
+		 * Start of the region.
+		 * @return Pointer to the region.
+		 */
+		void* data() const {
+			return base;
+		}
+		
+		/**
+		 * Size of the region.
+		 * @return Size in bytes, a multiple of the page size.
+		 */
+		size_t size() const {
+			return pages*page_size;
+		}
+		
+		/**
+		 * Number of pages written since they were last cleaned.
+		 * @return Page count.
+		 */
+		size_t dirty_pages() const {
+			size_t count = 0;
+			for(size_t i = 0; i < pages; ++i){
+				count += ((state[i].load(std::memory_order_relaxed) & STATE_MASK) == DIRTY);
+			}
+			return count;
+		}
+	
+	protected:
+		/**
+		 * Destructor, not virtual since regions are not deleted through
+		 * page_tracker.
+		 */
+		~page_tracker() {
+			for(auto& slot : registry()){
+				page_tracker* expected = this;
+				slot.compare_exchange_strong(expected, nullptr);
+			}
+			unmap();
+		}
+		
+		/**
+		 * State of a page.
+		 * @param page Page index.
+		 * @return CLEAN, DIRTY or BUSY in the low bits, the generation above
+		 * them.
+		 */
+		uint32_t state_of(size_t page) const {
+			return state[page].load(std::memory_order_acquire);
+		}
+		
+		/**
+		 * Check that a page was not locked since its state was read, so that
+		 * the bytes read in between are consistent with its ECC.
+		 * @param page Page index.
+		 * @param seen State returned by state_of().
+		 * @return true if the state is unchanged.
+		 */
+		bool unchanged(size_t page, uint32_t seen) const {
+			// Orders the reads of the page before the reload, as in a seqlock
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return state[page].load(std::memory_order_relaxed) == seen;
+		}
+		
+		/**
+		 * Lock a dirty page and write-protect it, so that it can be encoded.
+		 * Writes that land before the page is protected are seen by the
+		 * encoder, later writes fault and wait for unlock().
+		 * @param page Page index.
+		 * @return true if the page was dirty and is now locked.
+		 */
+		bool lock_dirty(size_t page) {
+			uint32_t expected = state[page].load(std::memory_order_relaxed);
+			if((expected & STATE_MASK) != DIRTY ||
+				!state[page].compare_exchange_strong(expected, expected - DIRTY + BUSY, std::memory_order_acq_rel)){
+				return false;
+			}
+			mprotect(base + page*page_size, page_size, PROT_READ);
+			return true;
+		}
+		
+		/**
+		 * Lock a clean page, so that it can be repaired.
+		 * @param page Page index.
+		 * @param seen State returned by state_of() before the page was read.
+		 * @return false if the page was locked since, in which case the bytes
+		 * read may be stale and the page is not locked.
+		 */
+		bool lock_clean(size_t page, uint32_t seen) {
+			return (seen & STATE_MASK) == CLEAN &&
+				state[page].compare_exchange_strong(seen, seen - CLEAN + BUSY, std::memory_order_acq_rel);
+		}
+		
+		/**
+		 * Unlock a page locked by lock_dirty() or lock_clean(), marking it
+		 * clean in a new generation.
+		 * @param page Page index.
+		 * @return New state of the page.
+		 */
+		uint32_t unlock(size_t page) {
+			uint32_t next = (state[page].load(std::memory_order_relaxed) & ~uint32_t(STATE_MASK)) + GENERATION + CLEAN;
+			state[page].store(next, std::memory_order_release);
+			return next;
+		}
+		
+		/**
+		 * Write to a page locked by lock_clean() without marking it dirty.
+		 * The page stays write-protected, so other writers are held off
+		 * until it is unlocked.
+		 * @param page Page index.
+		 * @param offset Offset in the page.
+		 * @param src Bytes to write.
+		 * @param length Number of bytes.
+		 */
+		void repair(size_t page, size_t offset, const void* src, size_t length) {
+			memcpy(alias + page*page_size + offset, src, length);
+		}
+		
+		const size_t page_size;                      ///< Page size in bytes.
+		const size_t pages;                          ///< Number of pages.
+		uint8_t* base = nullptr;                     ///< Start of the region.
+	
+	private:
+		/**
+		 * Map the region read-only, and again writable for repairs.
+		 * @return true if both mappings were made.
+		 */
+		bool map() {
+			const size_t length = pages*page_size;
+			int fd = memfd_create("rhs_ecc_region", MFD_CLOEXEC);
+			if(fd < 0){
+				return false;
+			}
+			void* p = MAP_FAILED;
+			void* q = MAP_FAILED;
+			if(ftruncate(fd, length) == 0){
+				p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+				q = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			}
+			close(fd);
+			if(p == MAP_FAILED || q == MAP_FAILED){
+				if(p != MAP_FAILED){
+					munmap(p, length);
+				}
+				if(q != MAP_FAILED){
+					munmap(q, length);
+				}
+				return false;
+			}
+			base = static_cast<uint8_t*>(p);
+			alias = static_cast<uint8_t*>(q);
+			return true;
+		}
+		
+		/**
+		 * Unmap both mappings of the region.
+		 */
+		void unmap() {
+			munmap(base, pages*page_size);
+			munmap(alias, pages*page_size);
+			base = nullptr;
+			alias = nullptr;
+		}
+		
+		/**
+		 * Live regions, looked up by the signal handler.
+		 * @return Registry slots.
+		 */
+		static std::atomic<page_tracker*> (&registry())[MAX_REGIONS] {
+			static std::atomic<page_tracker*> slots[MAX_REGIONS];
+			return slots;
+		}
+		
+		/**
+		 * Handler that was installed before ours.
+		 * @return Previous action.
+		 */
+		static struct sigaction& previous() {
+			static struct sigaction action;
+			return action;
+		}
+		
+		/**
+		 * Install the SIGSEGV handler once.
+		 */
+		static void install() {
+			static std::once_flag once;
+			std::call_once(once, []() {
+				struct sigaction action = {};
+				action.sa_sigaction = &page_tracker::fault;
+				action.sa_flags = SA_SIGINFO | SA_RESTART;
+				sigemptyset(&action.sa_mask);
+				sigaction(SIGSEGV, &action, &previous());
+			});
+		}
+		
+		/**
+		 * SIGSEGV handler.
+		 * @param sig Signal number.
+		 * @param info Fault information.
+		 * @param context Interrupted context.
+		 */
+		static void fault(int sig, siginfo_t* info, void* context) {
+			uint8_t* addr = static_cast<uint8_t*>(info->si_addr);
+			for(auto& slot : registry()){
+				page_tracker* r = slot.load(std::memory_order_acquire);
+				if(r != nullptr && addr >= r->base && addr < r->base + r->pages*r->page_size){
+					size_t page = (addr - r->base) / r->page_size;
+					std::atomic<uint32_t>& s = r->state[page];
+					uint32_t word = s.load(std::memory_order_acquire);
+					while((word & STATE_MASK) != DIRTY){
+						if((word & STATE_MASK) == BUSY){
+							// Wait for the page to be unlocked, the lock
+							// holder does not fault
+							word = s.load(std::memory_order_acquire);
+						}else if(s.compare_exchange_weak(word, word - CLEAN + BUSY, std::memory_order_acq_rel)){
+							// Unprotect under the lock, so that the page is
+							// never writable while it is marked clean
+							mprotect(r->base + page*r->page_size, r->page_size, PROT_READ | PROT_WRITE);
+							s.store(word - CLEAN + DIRTY, std::memory_order_release);
+							break;
+						}
+					}
+					return;
+				}
+			}
+			// Not ours, pass it on
+			struct sigaction& prev = previous();
+			if(prev.sa_flags & SA_SIGINFO){
+				prev.sa_sigaction(sig, info, context);
+			}else if(prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN){
+				prev.sa_handler(sig);
+			}else{
+				// Fault again with the default action, an ignored fault would
+				// restart the faulting instruction forever
+				struct sigaction action = {};
+				action.sa_handler = SIG_DFL;
+				sigemptyset(&action.sa_mask);
+				sigaction(SIGSEGV, &action, nullptr);
+			}
+		}
+		
+		uint8_t* alias = nullptr;                       ///< Writable mapping of the region.
+		std::unique_ptr<std::atomic<uint32_t>[]> state; ///< State and generation of each page.
+};
+
+/**
+ * Memory region whose ECC is maintained for the pages that are written.
+ * The region can be written through plain pointers, e.g. by code that
+ * cannot use ecc_obj.  commit() recalculates the ECC of only the pages
+ * written since the last commit; verify() and correct() cover the pages
+ * that are not dirty.
+ * @tparam Codec Symbol representation, see reedsolomon.
+ */
+template<typename Codec=conventional_codec>
+class ecc_region : public page_tracker {
+	public:
+		enum {
+			BLOCK_SIZE = Codec::NN,                   ///< Encoded block length in bytes.
+			DATA_SIZE = Codec::NN - Codec::NROOTS,    ///< Message data length in bytes.
+		};
+		
+		/**
+		 * Constructor, the region is zero-filled.
+		 * @param size Size of the region in bytes, rounded up to whole pages.
+		 * @throw std::bad_alloc if the region cannot be mapped, see
+		 * page_tracker.
+		 */
+		explicit ecc_region(size_t size) :
+			page_tracker(size),
+			page_blocks((page_size + DATA_SIZE - 1) / DATA_SIZE),
+			parity(pages*page_blocks*(BLOCK_SIZE-DATA_SIZE))
+		{
+			for(size_t page = 0; page < pages; ++page){
+				encode(page);
+			}
+		}
+		
+		/**
+		 * Recalculate the ECC of the pages written since the last commit.
+		 * @return Number of pages recalculated.
+		 */
+		size_t commit() {
+			size_t count = 0;
+			for(size_t page = 0; page < pages; ++page){
+				if(lock_dirty(page)){
+					encode(page);
+					unlock(page);
+					++count;
+				}
+			}
+			return count;
+		}
+		
+		/**
+		 * Verify the pages that are not dirty.
+		 * @return Error code.
+		 * @retval RHS_EOK if checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
+		 */
+		rhs_error_t verify() const {
+			for(size_t page = 0; page < pages; ++page){
+				uint32_t seen = state_of(page);
+				if((seen & STATE_MASK) != CLEAN){
+					// ECC is stale until the next commit
+					continue;
+				}
+				for(size_t block = 0; block < page_blocks; ++block){
+					if(Codec::check(block_of(page, block), parity_of(page, block), pad_of(block)) != 0){
+						if(!unchanged(page, seen)){
+							// Locked while it was read, ECC may be stale
+							break;
+						}
+						report(EVENT_NOTVERIFIED, base, page*page_blocks + block);
+						return RHS_ENOTVERIFIED;
+					}
+				}
+			}
+			return RHS_EOK;
+		}
+		
+		/**
+		 * Correct errors in the pages that are not dirty.
+		 * @return Error code.
+		 * @retval RHS_EOK if checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
+		 * @retval RHS_ENOTCORRECTED if correction fails.
+		 */
+		rhs_error_t correct() {
+			rhs_error_t ret = RHS_EOK;
+			for(size_t page = 0; page < pages; ++page){
+				uint32_t seen = state_of(page);
+				if((seen & STATE_MASK) != CLEAN){
+					// ECC is stale until the next commit
+					continue;
+				}
+				for(size_t block = 0; block < page_blocks; ++block){
+					size_t len = DATA_SIZE - pad_of(block);
+					uint8_t* pptr = parity_of(page, block);
+					uint8_t code[BLOCK_SIZE];
+					memcpy(code, block_of(page, block), len);
+					memcpy(&code[len], pptr, BLOCK_SIZE-DATA_SIZE);
+					int r = Codec::decode(code, NULL, 0, pad_of(block));
+					if(r > 0){
+						// An error was found
+						if(!lock_clean(page, seen)){
+							// Locked since it was read, ECC may be stale
+							break;
+						}
+						repair(page, block*DATA_SIZE, code, len);
+						memcpy(pptr, &code[len], BLOCK_SIZE-DATA_SIZE);
+						seen = unlock(page);
+						report(EVENT_CORRECTED, base, page*page_blocks + block, r);
+						if(ret == RHS_EOK){
+							ret = RHS_ENOTVERIFIED;
+						}
+					}else if(r < 0){
+						if(!unchanged(page, seen)){
+							// Locked while it was read, ECC may be stale
+							break;
+						}
+						// An uncorrectable error was found
+						report(EVENT_NOTCORRECTED, base, page*page_blocks + block);
+						ret = RHS_ENOTCORRECTED;
+					}
+				}
+			}
+			return ret;
+		}
+	
+	private:
+		/**
+		 * Calculate the ECC of a page.
+		 * @param page Page index.
+		 */
+		void encode(size_t page) {
+			for(size_t block = 0; block < page_blocks; ++block){
+				Codec::encode(block_of(page, block), parity_of(page, block), pad_of(block));
+			}
+		}
+		
+		/**
+		 * Data of a block.
+		 * @param page Page index.
+		 * @param block Block index in the page.
+		 * @return Pointer to the block's data bytes.
+		 */
+		uint8_t* block_of(size_t page, size_t block) const {
+			return base + page*page_size + block*DATA_SIZE;
+		}
+		
+		/**
+		 * Parity of a block.
+		 * @param page Page index.
+		 * @param block Block index in the page.
+		 * @return Pointer to the block's parity bytes.
+		 */
+		uint8_t* parity_of(size_t page, size_t block) const {
+			return const_cast<uint8_t*>(&parity[(page*page_blocks + block)*(BLOCK_SIZE-DATA_SIZE)]);
+		}
+		
+		/**
+		 * Number of virtual padding bytes in a block.
+		 * @param block Block index in the page.
+		 * @return Padding in bytes.
+		 */
+		int pad_of(size_t block) const {
+			return (block == page_blocks-1) ? page_blocks*DATA_SIZE - page_size : 0;
+		}
+		
+		const size_t page_blocks;    ///< Blocks per page.
+		std::vector<uint8_t> parity; ///< ECC of every block.
+};
+
+} // namespace rhs
+
+#endif // _RHS_ECCREGION_H_
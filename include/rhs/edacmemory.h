@@ -8,31 +8,130 @@
 #define _RHS_EDACMEMORY_H_
 
 #include "error.h"
+#include "executor.h"
+#include "freshness.h"
+#include "registry.h"
+#include "telemetry.h"
+#include "parity.h"
+#include "vote.h"
+#include "tmrexpr.h"
 extern "C" {
 #include "fec.h"
 }
 #include <cstdint>
-#include <iostream>
 #include <functional>
 #include <cstring>
+#include <algorithm>
+#include <type_traits>
 
 namespace rhs {
 
+/**
+ * CCSDS (255,223) codec with conventional symbol representation.
+ * Fastest choice for in-memory protection where the parity is never
+ * exchanged with other CCSDS implementations.
+ */
+struct conventional_codec {
+	enum {
+		NN = 255,    ///< Symbols per block.
+		NROOTS = 32, ///< Parity symbols per block.
+	};
+	
+	/** Encode a block, see encode_rs_8(). */
+	static void encode(uint8_t* data, uint8_t* parity, int pad) {
+		encode_rs_8(data, parity, pad);
+	}
+	
+	/** Decode and correct a block, see decode_rs_8(). */
+	static int decode(uint8_t* data, int* eras_pos, int no_eras, int pad) {
+		return decode_rs_8(data, eras_pos, no_eras, pad);
+	}
+	
+	/** Check a block without decoding, see check_rs_8(). */
+	static int check(uint8_t* data, uint8_t* parity, int pad) {
+		return check_rs_8(data, parity, pad);
+	}
+	
+	/** Check many blocks without decoding, see check_rs_8_batch(). */
+	static int check_batch(uint8_t** data, uint8_t** parity, int count, int pad, int* result) {
+		return check_rs_8_batch(data, parity, count, pad, result);
+	}
+	
+	/** Patch parity for changed symbols, see update_rs_8(). */
+	static int update(uint8_t* parity, int pos, uint8_t* delta, int len, int pad) {
+		return update_rs_8(parity, pos, delta, len, pad);
+	}
+};
+
+/**
+ * CCSDS (255,223) codec with dual-basis symbol representation.
+ * Compatible with CCSDS on-wire data, at the cost of a basis conversion
+ * of every symbol.
+ */
+struct ccsds_codec {
+	enum {
+		NN = 255,    ///< Symbols per block.
+		NROOTS = 32, ///< Parity symbols per block.
+	};
+	
+	/** Encode a block, see encode_rs_ccsds(). */
+	static void encode(uint8_t* data, uint8_t* parity, int pad) {
+		encode_rs_ccsds(data, parity, pad);
+	}
+	
+	/** Decode and correct a block, see decode_rs_ccsds(). */
+	static int decode(uint8_t* data, int* eras_pos, int no_eras, int pad) {
+		return decode_rs_ccsds(data, eras_pos, no_eras, pad);
+	}
+	
+	/** Check a block without decoding, see check_rs_ccsds(). */
+	static int check(uint8_t* data, uint8_t* parity, int pad) {
+		return check_rs_ccsds(data, parity, pad);
+	}
+	
+	/** Check many blocks without decoding, see check_rs_ccsds_batch(). */
+	static int check_batch(uint8_t** data, uint8_t** parity, int count, int pad, int* result) {
+		return check_rs_ccsds_batch(data, parity, count, pad, result);
+	}
+	
+	/** Patch parity for changed symbols, see update_rs_ccsds(). */
+	static int update(uint8_t* parity, int pos, uint8_t* delta, int len, int pad) {
+		return update_rs_ccsds(parity, pos, delta, len, pad);
+	}
+};
+
+/**
+ * Range of bytes in a protected object.
+ */
+struct byte_range {
+	size_t offset; ///< Offset of the first byte.
+	size_t length; ///< Number of bytes.
+};
+
 /**
  * Reed-Solomon
+ * The object is split into DATA_SIZE byte blocks.  The last block is
+ * shortened: its missing leading bytes are virtual zeros that are neither
+ * stored nor processed.
  * @tparam T Type to correct over.
+ * @tparam B Type of the stored object, sizeof(B) must equal sizeof(T).
+ * @tparam Codec Symbol representation, conventional_codec, ccsds_codec, or an rs_codec with 8-bit symbols.
+ * @tparam Layout Parity storage, inline_parity or arena_parity.
  */
-template<typename T, typename B>
+template<typename T, typename B, typename Codec=conventional_codec, typename Layout=inline_parity>
 class reedsolomon {
 	public:
 		enum {
-			BLOCK_SIZE = 255, ///< Encoded block length in bytes.
-			DATA_SIZE = 223,  ///< Message data length in bytes.
+			BLOCK_SIZE = Codec::NN,                 ///< Encoded block length in bytes.
+			DATA_SIZE = Codec::NN - Codec::NROOTS,  ///< Message data length in bytes.
 			_remainder = sizeof(T) % DATA_SIZE,
-			PAD_SIZE = (_remainder == 0) ? 0 : (DATA_SIZE - _remainder),        ///< Padding needed to round to BLOCK_SIZE.
-			PADDED_SIZE = sizeof(T) + PAD_SIZE,                                 ///< Total object size with padding in bytes.
-			PARITY_SIZE = (PADDED_SIZE / DATA_SIZE) * (BLOCK_SIZE - DATA_SIZE), ///< Size of additional parity data in bytes.
+			PAD_SIZE = (_remainder == 0) ? 0 : (DATA_SIZE - _remainder),        ///< Virtual padding of the last block in bytes.
+			PADDED_SIZE = sizeof(T) + PAD_SIZE,                                 ///< Object size including virtual padding in bytes.
+			BLOCKS = PADDED_SIZE / DATA_SIZE,                                   ///< Number of encoded blocks.
+			PARITY_SIZE = BLOCKS * (BLOCK_SIZE - DATA_SIZE),                    ///< Size of additional parity data in bytes.
 		};
+		static_assert(sizeof(B) == sizeof(T), "Stored object must not be padded");
+		static_assert(Codec::NN == 255, "Codec must use 8-bit symbols");
 
 		explicit reedsolomon(const B& data) {
 			calculate(data);
@@ -44,11 +143,53 @@ class reedsolomon {
 		 */
 		void calculate(const B& data) {
 			const uint8_t* dptr = reinterpret_cast<const uint8_t*>(&data);
-			uint8_t* pptr = parity;
-			for(size_t rem = PADDED_SIZE; rem > 0; rem -= DATA_SIZE){
-				encode_rs_ccsds(const_cast<uint8_t*>(dptr), pptr, 0);
-				dptr += DATA_SIZE;
-				pptr += (BLOCK_SIZE-DATA_SIZE);
+			for_each_block([&](size_t block) {
+				Codec::encode(const_cast<uint8_t*>(&dptr[block*DATA_SIZE]), parity_of(block), pad_of(block));
+			});
+		}
+		
+		/**
+		 * Recalculate the checksum of the blocks overlapping a changed range.
+		 * @param data Object to checksum.
+		 * @param offset Offset of the changed bytes in data.
+		 * @param length Number of changed bytes.
+		 */
+		void calculate(const B& data, size_t offset, size_t length) {
+			if(length == 0){
+				return;
+			}
+			const uint8_t* dptr = reinterpret_cast<const uint8_t*>(&data);
+			size_t last = (offset + length - 1) / DATA_SIZE;
+			for(size_t block = offset / DATA_SIZE; block <= last; ++block){
+				Codec::encode(const_cast<uint8_t*>(&dptr[block*DATA_SIZE]), parity_of(block), pad_of(block));
+			}
+		}
+		
+		/**
+		 * Update stored checksum from the previous value of a changed range.
+		 * Only the changed bytes are processed, so the cost is proportional
+		 * to length rather than to the size of the object.
+		 * @param data Object to checksum, after the change.
+		 * @param offset Offset of the changed bytes in data.
+		 * @param length Number of changed bytes.
+		 * @param old Contents of the changed bytes before the change.
+		 */
+		void update(const B& data, size_t offset, size_t length, const void* old) {
+			const uint8_t* dptr = reinterpret_cast<const uint8_t*>(&data) + offset;
+			const uint8_t* optr = reinterpret_cast<const uint8_t*>(old);
+			while(length > 0){
+				size_t block = offset / DATA_SIZE;
+				size_t pos = offset % DATA_SIZE;
+				size_t len = std::min(length, static_cast<size_t>(DATA_SIZE) - pos);
+				uint8_t delta[DATA_SIZE];
+				for(size_t i = 0; i < len; ++i){
+					delta[i] = dptr[i] ^ optr[i];
+				}
+				Codec::update(parity_of(block), pos, delta, len, pad_of(block));
+				offset += len;
+				dptr += len;
+				optr += len;
+				length -= len;
 			}
 		}
 		
@@ -59,23 +200,28 @@ class reedsolomon {
 		 * @retval RHS_EOK if checksum verifies.
 		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
 		 */
-		rhs_error_t verify(const B& data) {
-			rhs_error_t ret = RHS_EOK;
+		rhs_error_t verify(const B& data) const {
 			const uint8_t* dptr = reinterpret_cast<const uint8_t*>(&data);
-			uint8_t* pptr = parity;
-			for(size_t rem = PADDED_SIZE; rem > 0; rem -= DATA_SIZE){
-				uint8_t block[BLOCK_SIZE];
-				memcpy(block, dptr, DATA_SIZE);
-				memcpy(&block[DATA_SIZE], pptr, PARITY_SIZE);
-				int r = decode_rs_ccsds(block, NULL, 0, 0);
+			if(executor* exec = get_executor(BLOCKS)){
+				std::atomic<bool> ok(true);
+				exec->parallel_for(BLOCKS, [&](size_t block) {
+					if(ok.load(std::memory_order_relaxed) && Codec::check(const_cast<uint8_t*>(&dptr[block*DATA_SIZE]), const_cast<uint8_t*>(parity_of(block)), pad_of(block)) != 0){
+						ok.store(false, std::memory_order_relaxed);
+						report(EVENT_NOTVERIFIED, &data, block);
+					}
+				});
+				return ok ? RHS_EOK : RHS_ENOTVERIFIED;
+			}
+			for(size_t block = 0; block < BLOCKS; ++block){
+				// Syndromes only, in place, no decoding
+				int r = Codec::check(const_cast<uint8_t*>(&dptr[block*DATA_SIZE]), const_cast<uint8_t*>(parity_of(block)), pad_of(block));
 				if(r != 0){
 					// An error was found
-					ret = RHS_ENOTVERIFIED;
+					report(EVENT_NOTVERIFIED, &data, block);
+					return RHS_ENOTVERIFIED;
 				}
-				dptr += DATA_SIZE;
-				pptr += (BLOCK_SIZE-DATA_SIZE);
 			}
-			return ret;
+			return RHS_EOK;
 		}
 		
 		/**
@@ -87,98 +233,268 @@ class reedsolomon {
 		 * @retval RHS_ENOTCORRECTED if correction fails.
 		 */
 		rhs_error_t correct(B& data) {
-			rhs_error_t ret = RHS_EOK;
-			uint8_t* dptr = reinterpret_cast<uint8_t*>(&data);
-			uint8_t* pptr = parity;
-			for(size_t rem = PADDED_SIZE; rem > 0; rem -= DATA_SIZE){
-				uint8_t block[BLOCK_SIZE];
-				memcpy(block, dptr, DATA_SIZE);
-				memcpy(&block[DATA_SIZE], pptr, PARITY_SIZE);
-				int r = decode_rs_ccsds(block, NULL, 0, 0);
+			return correct(data, nullptr, 0);
+		}
+		
+		/**
+		 * Correct errors, with bytes known to be bad decoded as erasures.
+		 * A block can correct twice as many erasures as unknown errors, so
+		 * localized damage is repaired where it would otherwise be
+		 * uncorrectable.  If more bytes of a block are marked than it has
+		 * parity bytes, that block is decoded without erasures.
+		 * @param data Object to correct.
+		 * @param erasures Ranges of bytes in data that are known to be bad.
+		 * @param count Number of ranges.
+		 * @return Error code.
+		 * @retval RHS_EOK if checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
+		 * @retval RHS_ENOTCORRECTED if correction fails.
+		 */
+		rhs_error_t correct(B& data, const byte_range* erasures, size_t count) {
+			std::atomic<bool> found(false);
+			std::atomic<bool> failed(false);
+			for_each_block([&](size_t block) {
+				int eras_pos[BLOCK_SIZE-DATA_SIZE];
+				int no_eras = erasures_of(block, erasures, count, eras_pos);
+				int r = decode(data, block, (no_eras > 0) ? eras_pos : NULL, no_eras);
 				if(r != 0){
-					// An error was found
-					memcpy(dptr, &block, DATA_SIZE);
-					if(ret != RHS_ENOTCORRECTED){
-						ret = RHS_ENOTVERIFIED;
-					}
+					found.store(true, std::memory_order_relaxed);
 				}
 				if(r < 0){
-					// An uncorrectable error was found
-					ret = RHS_ENOTCORRECTED;
+					failed.store(true, std::memory_order_relaxed);
 				}
-				dptr += DATA_SIZE;
-				pptr += (BLOCK_SIZE-DATA_SIZE);
+			});
+			if(failed){
+				return RHS_ENOTCORRECTED;
 			}
-			return ret;
+			return found ? RHS_ENOTVERIFIED : RHS_EOK;
+		}
+		
+		/**
+		 * Correct errors in one block.
+		 * The syndromes are checked first, so a block without errors is
+		 * only read.
+		 * @param data Object to correct.
+		 * @param block Block index.
+		 * @return Error code, see correct(B&).
+		 */
+		rhs_error_t correct_block(B& data, size_t block) {
+			uint8_t* dptr = reinterpret_cast<uint8_t*>(&data);
+			if(Codec::check(&dptr[block*DATA_SIZE], parity_of(block), pad_of(block)) == 0){
+				return RHS_EOK;
+			}
+			int r = decode(data, block, NULL, 0);
+			if(r < 0){
+				return RHS_ENOTCORRECTED;
+			}
+			return (r > 0) ? RHS_ENOTVERIFIED : RHS_EOK;
+		}
+		
+		/**
+		 * Number of virtual padding bytes in a block.
+		 * @param block Block index.
+		 * @return Padding in bytes.
+		 */
+		static constexpr int pad_of(size_t block) {
+			return (block == BLOCKS-1) ? PAD_SIZE : 0;
+		}
+		
+		/**
+		 * Parity of a block.
+		 * @param block Block index.
+		 * @return Pointer to the block's parity bytes.
+		 */
+		const uint8_t* parity_of(size_t block) const {
+			return &parity.data()[block*(BLOCK_SIZE-DATA_SIZE)];
 		}
 	
 	private:
-		uint8_t parity[PARITY_SIZE];
+		/**
+		 * Parity of a block.
+		 * @param block Block index.
+		 * @return Pointer to the block's parity bytes.
+		 */
+		uint8_t* parity_of(size_t block) {
+			return &parity.data()[block*(BLOCK_SIZE-DATA_SIZE)];
+		}
+		
+		/**
+		 * Decode one block and write back the corrected data and parity.
+		 * @param data Object to correct.
+		 * @param block Block index.
+		 * @param eras_pos Erased positions in the padded block, or NULL.
+		 * @param no_eras Number of erasures.
+		 * @return Number of corrected symbols, or -1 if correction failed.
+		 */
+		int decode(B& data, size_t block, int* eras_pos, int no_eras) {
+			uint8_t* dptr = reinterpret_cast<uint8_t*>(&data);
+			size_t len = DATA_SIZE - pad_of(block);
+			uint8_t* pptr = parity_of(block);
+			uint8_t code[BLOCK_SIZE];
+			memcpy(code, &dptr[block*DATA_SIZE], len);
+			memcpy(&code[len], pptr, BLOCK_SIZE-DATA_SIZE);
+			int r = Codec::decode(code, eras_pos, no_eras, pad_of(block));
+			if(r != 0){
+				// An error was found
+				memcpy(&dptr[block*DATA_SIZE], code, len);
+				memcpy(pptr, &code[len], BLOCK_SIZE-DATA_SIZE);
+			}
+			if(r > 0){
+				report(EVENT_CORRECTED, &data, block, r);
+			}else if(r < 0){
+				// An uncorrectable error was found
+				report(EVENT_NOTCORRECTED, &data, block);
+			}
+			return r;
+		}
+		
+		/**
+		 * Call f for every block, in parallel if the object is large
+		 * enough for the configured executor, see set_executor().
+		 * @param f Function to call with each block index.
+		 */
+		template<typename F>
+		static void for_each_block(F&& f) {
+			if(executor* exec = get_executor(BLOCKS)){
+				exec->parallel_for(BLOCKS, f);
+			}else{
+				for(size_t block = 0; block < BLOCKS; ++block){
+					f(block);
+				}
+			}
+		}
+		
+		/**
+		 * Erasure positions of a block.
+		 * @param block Block index.
+		 * @param erasures Ranges of bytes in the object that are known to be bad.
+		 * @param count Number of ranges.
+		 * @param eras_pos Receives the erased positions in the padded block.
+		 * @return Number of erasures, 0 if there are more than the block can correct.
+		 */
+		static int erasures_of(size_t block, const byte_range* erasures, size_t count, int (&eras_pos)[BLOCK_SIZE-DATA_SIZE]) {
+			if(count == 0){
+				return 0;
+			}
+			size_t begin = block*DATA_SIZE;
+			size_t end = begin + DATA_SIZE - pad_of(block);
+			bool erased[DATA_SIZE] = {};
+			for(size_t i = 0; i < count; ++i){
+				size_t first = std::max(erasures[i].offset, begin);
+				size_t last = std::min(erasures[i].offset + erasures[i].length, end);
+				for(size_t j = first; j < last; ++j){
+					erased[j - begin] = true;
+				}
+			}
+			int no_eras = 0;
+			for(size_t j = 0; j < end - begin; ++j){
+				if(erased[j]){
+					if(no_eras == BLOCK_SIZE-DATA_SIZE){
+						// Too many to be of use
+						return 0;
+					}
+					eras_pos[no_eras++] = pad_of(block) + j;
+				}
+			}
+			return no_eras;
+		}
+		
+		typename Layout::template storage<PARITY_SIZE> parity; ///< Parity of every block.
 };
 
+template<typename T, typename Codec, typename Fresh, typename Reg, typename Layout>
+class ecc_obj;
+
+template<typename T, typename Codec, typename Fresh, typename Reg, typename Layout>
+rhs_error_t verify_all(const ecc_obj<T, Codec, Fresh, Reg, Layout>* objs, size_t count, rhs_error_t* results = nullptr);
+
 /**
  * ECC object wrapper.
  * @tparam T Type of wrapped object.
+ * @tparam Codec Symbol representation, conventional_codec, ccsds_codec, or an rs_codec with 8-bit symbols.
+ * @tparam Fresh Freshness policy, verify_always, verify_epoch, verify_window or verify_scrubbed.
+ *         Dereferencing skips verification while the last one is fresh;
+ *         verify() and correct() always run.
+ * @tparam Reg Registry policy, unregistered or registered.
+ * @tparam Layout Parity storage, inline_parity after the data or arena_parity
+ *         in a separate arena.
  */
-template<typename T>
-class ecc_obj {
+template<typename T, typename Codec=conventional_codec, typename Fresh=verify_always, typename Reg=unregistered, typename Layout=inline_parity>
+class ecc_obj : private Fresh, private Reg {
 	private:
-		struct data_t; // forward declaration
-		typedef reedsolomon<T, data_t> ECC; ///< ECC type
-		
-#pragma pack(push,1)
-		/**
-		 * Struct to keep object and padding together.
-		 */
-		struct data_t {
-			T obj;                          ///< Object being protected.
-			uint8_t padding[ECC::PAD_SIZE]; ///< Padding needed for message data.
-		} data;
-#pragma pack(pop)
-		static_assert(sizeof(data_t) % ECC::DATA_SIZE == 0, "Object is not padded correctly");
+		typedef reedsolomon<T, T, Codec, Layout> ECC; ///< ECC type
 		
+		T data;  ///< Object being protected.
 		ECC ecc; ///< ECC state.
-		static_assert((sizeof(data_t) + sizeof(ECC)) % ECC::BLOCK_SIZE == 0, "Encoded size is not correct");
+		static_assert(sizeof(ECC) == sizeof(typename Layout::template storage<ECC::PARITY_SIZE>), "Encoded size is not correct");
 	
 	public:
 		/**
 		 * Constructor.
 		 */
 		ecc_obj() :
-			data{{}, {0}},
+			data{},
 			ecc(data)
-		{}
+		{
+			Fresh::mark();
+			Reg::enroll(this);
+		}
 		
 		/**
 		 * Move constructor.
 		 * @param p Object to move.
 		 */
 		ecc_obj(const T&& p) : // cppcheck-suppress noExplicitConstructor
-			data{p, {0}},
+			data(p),
 			ecc(data)
-		{}
+		{
+			Fresh::mark();
+			Reg::enroll(this);
+		}
+		
+		/**
+		 * Copy constructor.
+		 * @param p Object to copy.
+		 */
+		ecc_obj(const ecc_obj& p) :
+			Fresh(p),
+			Reg(p),
+			data(p.data),
+			ecc(p.ecc)
+		{
+			Reg::enroll(this);
+		}
+		
+		ecc_obj& operator=(const ecc_obj&) = default;
 		
 		/**
 		 * Destructor.
 		 */
-		virtual ~ecc_obj() = default;
+		~ecc_obj() {
+			Reg::leave();
+		}
 		
 		/**
 		 * Dereference operator.
 		 * @return Reference to wrapped object.
 		 */
 		const T& operator*() const {
-			verify();
-			return data.obj;
+			if(!Fresh::fresh()){
+				verify();
+			}
+			return data;
 		}
 		
 		/**
-		 * Dereference operator.
+		 * Dereference operator, corrects errors.
+		 * Writes go through write(), so that the ECC follows them.
 		 * @return Reference to wrapped object.
 		 */
-		T& operator*() {
-			verifyAndCorrect();
-			return data.obj;
+		const T& operator*() {
+			if(!Fresh::fresh()){
+				verifyAndCorrect();
+			}
+			return data;
 		}
 		
 		/**
@@ -186,38 +502,87 @@ class ecc_obj {
 		 * @return Pointer to wrapped object.
 		 */
 		const T* operator->() const {
-			verify();
-			return &data.obj;
+			if(!Fresh::fresh()){
+				verify();
+			}
+			return &data;
 		}
 		
 		/**
-		 * Arrow operator.
+		 * Arrow operator, corrects errors.
+		 * Writes go through write(), so that the ECC follows them.
 		 * @return Pointer to wrapped object.
 		 */
-		T* operator->() {
-			verifyAndCorrect();
-			return &data.obj;
+		const T* operator->() {
+			if(!Fresh::fresh()){
+				verifyAndCorrect();
+			}
+			return &data;
 		}
 		
 		/**
 		 * Update the ECC for the wrapped object.
-		 * @note This must be called after the object is intentionally modified.
+		 * @note This must be called after the object is modified other than
+		 * through write().
 		 */
 		void update() {
-			std::memset(data.padding, 0, ECC::PAD_SIZE);
 			ecc.calculate(data);
 		}
 		
+		/**
+		 * Update the ECC for part of the wrapped object.
+		 * Only the blocks overlapping the changed bytes are recalculated.
+		 * @param offset Offset of the changed bytes in the object.
+		 * @param length Number of changed bytes.
+		 */
+		void update(size_t offset, size_t length) {
+			ecc.calculate(data, offset, length);
+		}
+		
+		/**
+		 * Update the ECC for part of the wrapped object from its previous value.
+		 * Only the changed bytes are processed.
+		 * @param offset Offset of the changed bytes in the object.
+		 * @param length Number of changed bytes.
+		 * @param old Contents of the changed bytes before the change.
+		 */
+		void update(size_t offset, size_t length, const void* old) {
+			ecc.update(data, offset, length, old);
+		}
+		
+		/**
+		 * Update the ECC for one member of the wrapped object.
+		 * @tparam M Type of the member.
+		 * @tparam C Class declaring the member, T or a base of T.
+		 * @param member Pointer to the changed member.
+		 */
+		template<typename M, typename C>
+		void update_field(M C::*member) {
+			update(offset_of(member), sizeof(M));
+		}
+		
+		/**
+		 * Update the ECC for one member of the wrapped object from its previous value.
+		 * @tparam M Type of the member.
+		 * @tparam C Class declaring the member, T or a base of T.
+		 * @param member Pointer to the changed member.
+		 * @param old Value of the member before the change.
+		 */
+		template<typename M, typename C>
+		void update_field(M C::*member, const M& old) {
+			update(offset_of(member), sizeof(M), &old);
+		}
+		
 		/**
 		 * Verify the integrity of the wrapped object.
 		 * @return Error code.
 		 * @retval RHS_EOK if checksum verifies.
 		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
 		 */
-		rhs_error_t verify() {
+		rhs_error_t verify() const {
 			rhs_error_t ret = ecc.verify(data);
-			if(ret == RHS_ENOTVERIFIED){
-				std::cout << "Verification failed" << std::endl;
+			if(ret == RHS_EOK){
+				Fresh::mark();
 			}
 			return ret;
 		}
@@ -231,12 +596,42 @@ class ecc_obj {
 		 */
 		rhs_error_t correct() {
 			rhs_error_t ret = ecc.correct(data);
-			if(ret == RHS_ENOTCORRECTED){
-				std::cout << "Correction failed" << std::endl;
+			if(ret != RHS_ENOTCORRECTED){
+				Fresh::mark();
 			}
 			return ret;
 		}
 		
+		/**
+		 * Correct errors in the wrapped object, with bytes known to be bad
+		 * decoded as erasures.
+		 * @param erasures Ranges of bytes in the object that are known to be bad.
+		 * @param count Number of ranges.
+		 * @return Error code.
+		 * @retval RHS_EOK if checksum verifies.
+		 * @retval RHS_ENOTVERIFIED if checksum does not verify.
+		 * @retval RHS_ENOTCORRECTED if correction fails.
+		 */
+		rhs_error_t correct(const byte_range* erasures, size_t count) {
+			rhs_error_t ret = ecc.correct(data, erasures, count);
+			if(ret != RHS_ENOTCORRECTED){
+				Fresh::mark();
+			}
+			return ret;
+		}
+		
+		/**
+		 * Correct errors in the wrapped object, with one range of bytes known
+		 * to be bad decoded as erasures.
+		 * @param offset Offset of the bad bytes in the object.
+		 * @param length Number of bad bytes.
+		 * @return Error code, see correct(const byte_range*, size_t).
+		 */
+		rhs_error_t correct(size_t offset, size_t length) {
+			byte_range erasure = {offset, length};
+			return correct(&erasure, 1);
+		}
+		
 		/**
 		 * Verify the integrity of the wrapped object and correct errors.
 		 * @return Error code.
@@ -254,32 +649,258 @@ class ecc_obj {
 			}
 			return ret;
 		}
+		
+		/**
+		 * Scoped write access to the wrapped object.
+		 * Records which blocks are written and recalculates the ECC of only
+		 * those blocks when it goes out of scope.  Each block is corrected
+		 * when it is first written, whatever the freshness policy, so that
+		 * no existing error is encoded into the new ECC.
+		 */
+		class writer {
+			public:
+				/**
+				 * Constructor.
+				 * @param obj Object to write.
+				 */
+				explicit writer(ecc_obj& obj) :
+					obj(obj)
+				{}
+				
+				/**
+				 * Destructor, recalculates the ECC of the written blocks.
+				 */
+				~writer() {
+					for(size_t block = 0; block < ECC::BLOCKS; ++block){
+						if(dirty[block]){
+							obj.update(block*ECC::DATA_SIZE, 1);
+						}
+					}
+				}
+				
+				writer(const writer&) = delete;
+				writer& operator=(const writer&) = delete;
+				
+				/**
+				 * Read access.
+				 * @return Reference to wrapped object.
+				 */
+				const T& operator*() const {
+					return obj.data;
+				}
+				
+				/**
+				 * Read access.
+				 * @return Pointer to wrapped object.
+				 */
+				const T* operator->() const {
+					return &obj.data;
+				}
+				
+				/**
+				 * Untracked write access, marks the whole object as written.
+				 * @return Pointer to wrapped object.
+				 */
+				T* operator->() {
+					touch(0, sizeof(T));
+					return &obj.data;
+				}
+				
+				/**
+				 * Write access to one member.
+				 * @tparam M Type of the member.
+				 * @tparam C Class declaring the member, T or a base of T.
+				 * @param member Pointer to the member.
+				 * @return Reference to the member.
+				 */
+				template<typename M, typename C>
+				M& field(M C::*member) {
+					touch(obj.offset_of(member), sizeof(M));
+					return obj.data.*member;
+				}
+				
+				/**
+				 * Set one member.
+				 * @tparam M Type of the member.
+				 * @tparam C Class declaring the member, T or a base of T.
+				 * @param member Pointer to the member.
+				 * @param value New value.
+				 */
+				template<typename M, typename C>
+				void set(M C::*member, const M& value) {
+					field(member) = value;
+				}
+				
+				/**
+				 * Write access to a range of bytes.
+				 * @param offset Offset of the bytes in the object.
+				 * @param length Number of bytes.
+				 * @return Pointer to the first byte.
+				 */
+				void* bytes(size_t offset, size_t length) {
+					touch(offset, length);
+					return reinterpret_cast<uint8_t*>(&obj.data) + offset;
+				}
+				
+			private:
+				/**
+				 * Mark the blocks overlapping a range as written, correcting
+				 * each one before it is first written.
+				 * @param offset Offset of the bytes in the object.
+				 * @param length Number of bytes.
+				 */
+				void touch(size_t offset, size_t length) {
+					if(length == 0){
+						return;
+					}
+					size_t last = (offset + length - 1) / ECC::DATA_SIZE;
+					for(size_t block = offset / ECC::DATA_SIZE; block <= last; ++block){
+						if(!dirty[block]){
+							obj.ecc.correct_block(obj.data, block);
+							dirty[block] = true;
+						}
+					}
+				}
+				
+				ecc_obj& obj;                 ///< Object being written.
+				bool dirty[ECC::BLOCKS] = {}; ///< Blocks written.
+		};
+		
+		/**
+		 * Scoped write access, see writer.
+		 * @return Write handle.
+		 */
+		writer write() {
+			return writer(*this);
+		}
+	
+	private:
+		friend rhs_error_t verify_all<T, Codec, Fresh, Reg, Layout>(const ecc_obj<T, Codec, Fresh, Reg, Layout>* objs, size_t count, rhs_error_t* results);
+		
+		/**
+		 * Offset of a member in the wrapped object.
+		 * @tparam M Type of the member.
+		 * @tparam C Class declaring the member, T or a base of T.
+		 * @param member Pointer to the member.
+		 * @return Offset in bytes.
+		 */
+		template<typename M, typename C>
+		size_t offset_of(M C::*member) const {
+			return reinterpret_cast<const uint8_t*>(&(data.*member)) - reinterpret_cast<const uint8_t*>(&data);
+		}
 };
 
 /**
  * Make an ecc_obj.
  * @tparam T Type of wrapped object.
+ * @tparam Codec Symbol representation, conventional_codec, ccsds_codec, or an rs_codec with 8-bit symbols.
+ * @tparam Fresh Freshness policy, see ecc_obj.
+ * @tparam Reg Registry policy, see ecc_obj.
+ * @tparam Layout Parity storage, see ecc_obj.
  * @tparam Args Types of arguments for constructor.
  * @param args Arguments for constructor
  * @return New ecc_obj.
  */
-template<typename T, typename... Args>
-ecc_obj<T> make_ecc(Args&&... args) {
-	return ecc_obj<T>(T(args...));
+template<typename T, typename Codec=conventional_codec, typename Fresh=verify_always, typename Reg=unregistered, typename Layout=inline_parity, typename... Args>
+ecc_obj<T, Codec, Fresh, Reg, Layout> make_ecc(Args&&... args) {
+	return ecc_obj<T, Codec, Fresh, Reg, Layout>(T(args...));
+}
+
+/**
+ * Verify the integrity of many ecc_obj.
+ * The blocks of all objects are checked in batches through
+ * Codec::check_batch(), which prefetches each block ahead of use.
+ * @param objs Objects to verify.
+ * @param count Number of objects.
+ * @param results If not NULL, receives the result of each object.
+ * @return Error code.
+ * @retval RHS_EOK if every checksum verifies.
+ * @retval RHS_ENOTVERIFIED if any checksum does not verify.
+ */
+template<typename T, typename Codec, typename Fresh, typename Reg, typename Layout>
+rhs_error_t verify_all(const ecc_obj<T, Codec, Fresh, Reg, Layout>* objs, size_t count, rhs_error_t* results) {
+	typedef typename ecc_obj<T, Codec, Fresh, Reg, Layout>::ECC ECC;
+	enum {
+		BATCH = 64, ///< Blocks per call to Codec::check_batch().
+	};
+	
+	rhs_error_t ret = RHS_EOK;
+	uint8_t* dptr[BATCH];
+	uint8_t* pptr[BATCH];
+	size_t owner[BATCH];
+	int index[BATCH];
+	int result[BATCH];
+	int pending = 0;
+	int pad = 0;
+	
+	// Check the pending blocks, which all have the same padding
+	auto flush = [&]() {
+		if(pending > 0 && Codec::check_batch(dptr, pptr, pending, pad, result) != 0){
+			ret = RHS_ENOTVERIFIED;
+			for(int i = 0; i < pending; ++i){
+				if(result[i] != 0){
+					report(EVENT_NOTVERIFIED, &objs[owner[i]].data, index[i]);
+					if(results != nullptr){
+						results[owner[i]] = RHS_ENOTVERIFIED;
+					}
+				}
+			}
+		}
+		pending = 0;
+	};
+	
+	if(results != nullptr){
+		std::fill(results, results + count, RHS_EOK);
+	}
+	// Full blocks first, then the shortened last blocks
+	for(size_t block = 0; block < ECC::BLOCKS; ++block){
+		int block_pad = ECC::pad_of(block);
+		if(block_pad != pad){
+			flush();
+			pad = block_pad;
+		}
+		for(size_t i = 0; i < count; ++i){
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(&objs[i].data);
+			dptr[pending] = const_cast<uint8_t*>(&data[block*ECC::DATA_SIZE]);
+			pptr[pending] = const_cast<uint8_t*>(objs[i].ecc.parity_of(block));
+			owner[pending] = i;
+			index[pending] = block;
+			if(++pending == BATCH){
+				flush();
+			}
+		}
+	}
+	flush();
+	return ret;
+}
+
+/**
+ * Verify the integrity of a contiguous container of ecc_obj.
+ * @tparam C Container type, e.g. std::vector or std::array of ecc_obj.
+ * @param objs Objects to verify.
+ * @param results If not NULL, receives the result of each object.
+ * @return Error code, see verify_all(const ecc_obj<T, Codec, Fresh, Reg, Layout>*, size_t, rhs_error_t*).
+ */
+template<typename C>
+auto verify_all(const C& objs, rhs_error_t* results = nullptr) -> decltype(verify_all(objs.data(), objs.size(), results)) {
+	return verify_all(objs.data(), objs.size(), results);
 }
 
 /**
  * Redundant object wrapper.
  * @tparam T Type of wrapped object.
  * @tparam N Number of redundant copies.
+ * @tparam Reg Registry policy, unregistered or registered.
  */
-template<typename T, unsigned int N=3>
-class tmr_obj {
+template<typename T, unsigned int N=3, typename Reg=unregistered>
+class tmr_obj : private Reg {
 	public:
 		/**
 		 * Constructor.
 		 */
-		tmr_obj() {}
+		tmr_obj() {
+			Reg::enroll(this);
+		}
 		
 		/**
 		 * Constructor.
@@ -289,22 +910,40 @@ class tmr_obj {
 			for(unsigned int i = 0; i < N; ++i){
 				obj[i] = p;
 			}
+			Reg::enroll(this);
 		}
 		
 		/**
 		 * Copy constructor.
 		 * @param p Original object
 		 */
-		tmr_obj(const tmr_obj<T>& p) {
+		tmr_obj(const tmr_obj& p) :
+			Reg(p)
+		{
 			for(unsigned int i = 0; i < N; ++i){
-				obj[i] = p;
+				obj[i] = p.obj[i];
 			}
+			Reg::enroll(this);
 		}
 		
+		/**
+		 * Constructor.
+		 * @param e Expression, e.g. b*c + d.
+		 */
+		template<typename Op, typename L, typename R>
+		tmr_obj(const tmr_binary<Op, L, R>& e) {  // cppcheck-suppress noExplicitConstructor
+			assign(e);
+			Reg::enroll(this);
+		}
+		
+		tmr_obj& operator=(const tmr_obj&) = default;
+		
 		/**
 		 * Destructor.
 		 */
-		virtual ~tmr_obj() = default;
+		~tmr_obj() {
+			Reg::leave();
+		}
 		
 		/**
 		 * Index operator.
@@ -330,56 +969,37 @@ class tmr_obj {
 			return obj[0];
 		}
 		
-		tmr_obj<T, N>& operator+=(tmr_obj<T> b){
-			verifyAndCorrect();
-			for(unsigned int i = 0; i < N; ++i){
-				obj[i] += b;
-			}
-			return *this;
-		}
-		
-		tmr_obj<T, N>& operator-=(tmr_obj<T> b){
-			verifyAndCorrect();
-			for(unsigned int i = 0; i < N; ++i){
-				obj[i] -= b;
-			}
-			return *this;
-		}
-		
-		tmr_obj<T, N>& operator*=(tmr_obj<T> b){
-			verifyAndCorrect();
-			for(unsigned int i = 0; i < N; ++i){
-				obj[i] *= b;
-			}
-			return *this;
-		}
-		
-		tmr_obj<T, N>& operator/=(tmr_obj<T> b){
-			verifyAndCorrect();
-			for(unsigned int i = 0; i < N; ++i){
-				obj[i] /= b;
-			}
+		/**
+		 * Assign the result of an expression.
+		 * Each operand is voted once, then each copy is computed from the
+		 * same copy of the operands.
+		 * @param e Expression, e.g. b*c + d.
+		 * @return This object.
+		 */
+		template<typename Op, typename L, typename R>
+		tmr_obj& operator=(const tmr_binary<Op, L, R>& e) {
+			assign(e);
 			return *this;
 		}
 		
-		tmr_obj<T, N> operator+(tmr_obj<T> b){
-			tmr_obj<T, N> ret(*this);
-			return ret += b;
+		template<typename E>
+		tmr_obj& operator+=(E&& b){
+			return apply(tmr_operand(b), [](T& a, const auto& v) { a += v; });
 		}
 		
-		tmr_obj<T, N> operator-(tmr_obj<T> b){
-			tmr_obj<T, N> ret(*this);
-			return ret -= b;
+		template<typename E>
+		tmr_obj& operator-=(E&& b){
+			return apply(tmr_operand(b), [](T& a, const auto& v) { a -= v; });
 		}
 		
-		tmr_obj<T, N> operator*(tmr_obj<T> b){
-			tmr_obj<T, N> ret(*this);
-			return ret *= b;
+		template<typename E>
+		tmr_obj& operator*=(E&& b){
+			return apply(tmr_operand(b), [](T& a, const auto& v) { a *= v; });
 		}
 		
-		tmr_obj<T, N> operator/(tmr_obj<T> b){
-			tmr_obj<T, N> ret(*this);
-			return ret /= b;
+		template<typename E>
+		tmr_obj& operator/=(E&& b){
+			return apply(tmr_operand(b), [](T& a, const auto& v) { a /= v; });
 		}
 		
 		/**
@@ -387,21 +1007,51 @@ class tmr_obj {
 		 * @return RHS_EOK if object is verified.
 		 */
 		rhs_error_t verify() {
-			bool ret = (obj[0] == obj[1]);
-			for(unsigned int i = 1; i < N; ++i){
-				ret = (obj[i-1] == obj[i]) && ret;
+			bool ret;
+			if constexpr(std::has_unique_object_representations_v<T>){
+				const uint8_t* copies[N];
+				for(unsigned int i = 0; i < N; ++i){
+					copies[i] = reinterpret_cast<const uint8_t*>(&obj[i]);
+				}
+				ret = same_bytes<N>(copies, sizeof(T));
+			}else{
+				ret = (obj[0] == obj[1]);
+				for(unsigned int i = 1; i < N; ++i){
+					ret = (obj[i-1] == obj[i]) && ret;
+				}
 			}
 			if(!ret){
-				std::cout << "Verification failed" << std::endl;
+				report(EVENT_NOTVERIFIED, this);
 			}
 			return ret ? RHS_EOK : RHS_ENOTVERIFIED;
 		}
 		
 		/**
 		 * Correct errors in the wrapped object.
+		 * Objects whose bytes are all part of their value, i.e. with unique
+		 * object representations, are voted bit by bit, so upsets in
+		 * different bits of several copies are repaired.  Other objects, e.g.
+		 * with padding, which copies need not agree on, or floating point
+		 * members, are voted as a whole with operator==.
 		 * @return RHS_EOK if object is corrected.
 		 */
 		rhs_error_t correct() {
+			if constexpr(std::has_unique_object_representations_v<T>){
+				uint8_t* copies[N];
+				for(unsigned int i = 0; i < N; ++i){
+					copies[i] = reinterpret_cast<uint8_t*>(&obj[i]);
+				}
+				int changed = vote_bytes<N>(copies, sizeof(T));
+				if(changed < 0){
+					report(EVENT_NOTCORRECTED, this);
+					return RHS_ENOTCORRECTED;
+				}
+				if(changed > 0){
+					report(EVENT_CORRECTED, this, -1, changed);
+				}
+				return RHS_EOK;
+			}
+			
 			unsigned int corrected = 0;
 			unsigned int most = 0;
 			
@@ -419,13 +1069,20 @@ class tmr_obj {
 			}
 			
 			if(most > 0){
+				int copies = 0;
 				for(unsigned int i = 0; i < N; ++i){
-					obj[i] = obj[corrected];
+					if(!(obj[i] == obj[corrected])){
+						obj[i] = obj[corrected];
+						++copies;
+					}
 				}
 				
+				if(copies > 0){
+					report(EVENT_CORRECTED, this, -1, copies);
+				}
 				return RHS_EOK;
 			}else{
-				std::cout << "Correction failed" << std::endl;
+				report(EVENT_NOTCORRECTED, this);
 				return RHS_ENOTCORRECTED;
 			}
 		}
@@ -446,6 +1103,36 @@ class tmr_obj {
 		}
 	
 	private:
+		/**
+		 * Write every copy from an expression.
+		 * @param e Expression.
+		 */
+		template<typename E>
+		void assign(const E& e) {
+			static_assert(E::replicas == N, "Expression must have the same number of copies");
+			e.prepare();
+			for(unsigned int i = 0; i < N; ++i){
+				obj[i] = e.replica(i);
+			}
+		}
+		
+		/**
+		 * Update every copy from an operand.
+		 * @param e Operand expression.
+		 * @param op Update of one copy.
+		 * @return This object.
+		 */
+		template<typename E, typename F>
+		tmr_obj& apply(const E& e, F op) {
+			static_assert(E::replicas == 0 || E::replicas == N, "Operand must have the same number of copies");
+			verifyAndCorrect();
+			e.prepare();
+			for(unsigned int i = 0; i < N; ++i){
+				op(obj[i], e.replica(i));
+			}
+			return *this;
+		}
+		
 		T obj[N]; ///< N redundant copies.
 };
 
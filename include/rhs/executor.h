@@ -0,0 +1,197 @@
+/**
+ * @file rhs/executor.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Parallel execution of independent codewords.
+ */
+
+#ifndef _RHS_EXECUTOR_H_
+#define _RHS_EXECUTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rhs {
+
+/**
+ * Runs a batch of independent tasks, possibly in parallel.
+ */
+class executor {
+	public:
+		/**
+		 * Destructor.
+		 */
+		virtual ~executor() = default;
+
+		/**
+		 * Call f once for every index, returning when all calls are done.
+		 * @param count Number of indices.
+		 * @param f Function to call with each index in [0, count).
+		 */
+		virtual void parallel_for(size_t count, const std::function<void(size_t)>& f) = 0;
+};
+
+/**
+ * Executor with a fixed set of worker threads.
+ * The calling thread works alongside the workers, and indices are handed
+ * out in small chunks from a shared counter so that threads which finish
+ * early take over the remaining work.  Batches from different threads are
+ * run one at a time.  A batch started from inside another batch runs
+ * serially on the calling thread.
+ */
+class thread_pool : public executor {
+	public:
+		/**
+		 * Constructor.
+		 * @param threads Number of threads, including the calling thread.
+		 */
+		explicit thread_pool(unsigned int threads = std::thread::hardware_concurrency()) {
+			for(unsigned int i = 1; i < threads; ++i){
+				workers.emplace_back(&thread_pool::run, this);
+			}
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~thread_pool() override {
+			{
+				std::lock_guard<std::mutex> l(lock);
+				stop = true;
+			}
+			wake.notify_all();
+			for(auto& w : workers){
+				w.join();
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		/**
+		 * Number of threads, including the calling thread.
+		 * @return Thread count.
+		 */
+		size_t size() const {
+			return workers.size() + 1;
+		}
+
+		void parallel_for(size_t count, const std::function<void(size_t)>& f) override {
+			if(nested){
+				for(size_t i = 0; i < count; ++i){
+					f(i);
+				}
+				return;
+			}
+			std::lock_guard<std::mutex> serial(submit);
+			{
+				std::lock_guard<std::mutex> l(lock);
+				job = &f;
+				job_count = count;
+				grain = std::max<size_t>(1, count / (8 * size()));
+				next = 0;
+				pending = workers.size();
+				++generation;
+			}
+			wake.notify_all();
+			work();
+			std::unique_lock<std::mutex> l(lock);
+			done.wait(l, [this]() { return pending == 0; });
+			job = nullptr;
+		}
+
+	private:
+		/**
+		 * Worker thread body.
+		 */
+		void run() {
+			uint64_t seen = 0;
+			std::unique_lock<std::mutex> l(lock);
+			for(;;){
+				wake.wait(l, [&]() { return stop || generation != seen; });
+				if(stop){
+					return;
+				}
+				seen = generation;
+				l.unlock();
+				work();
+				l.lock();
+				if(--pending == 0){
+					done.notify_one();
+				}
+			}
+		}
+
+		/**
+		 * Run chunks of the current batch until none are left.
+		 */
+		void work() {
+			nested = true;
+			for(;;){
+				size_t first = next.fetch_add(grain);
+				if(first >= job_count){
+					break;
+				}
+				size_t last = std::min(first + grain, job_count);
+				for(size_t i = first; i < last; ++i){
+					(*job)(i);
+				}
+			}
+			nested = false;
+		}
+
+		std::vector<std::thread> workers;   ///< Worker threads.
+		std::mutex submit;                  ///< Serializes batches.
+		std::mutex lock;                    ///< Protects the batch state.
+		std::condition_variable wake;       ///< Signals a new batch or shutdown.
+		std::condition_variable done;       ///< Signals that the workers finished a batch.
+		const std::function<void(size_t)>* job = nullptr; ///< Current batch.
+		size_t job_count = 0;               ///< Number of indices in the batch.
+		size_t grain = 1;                   ///< Indices per chunk.
+		std::atomic<size_t> next{0};        ///< Next unclaimed index.
+		size_t pending = 0;                 ///< Workers still running the batch.
+		uint64_t generation = 0;            ///< Batch counter.
+		bool stop = false;                  ///< Shut down the workers.
+		static inline thread_local bool nested = false; ///< This thread is running a batch.
+};
+
+/**
+ * Executor used by reedsolomon for large objects.
+ */
+struct parallel_policy {
+	static inline std::atomic<executor*> exec{nullptr};     ///< Executor, or NULL to run serially.
+	static inline std::atomic<size_t> min_blocks{256};      ///< Smallest number of blocks run in parallel.
+};
+
+/**
+ * Set the executor used to encode, verify and correct large objects.
+ * @param exec Executor, or NULL to always run serially.
+ * @param min_blocks Objects with fewer codewords are processed serially.
+ */
+inline void set_executor(executor* exec, size_t min_blocks = 256) {
+	parallel_policy::min_blocks = min_blocks;
+	parallel_policy::exec = exec;
+}
+
+/**
+ * Executor for an object.
+ * @param blocks Number of codewords in the object.
+ * @return Executor to use, or NULL to run serially.
+ */
+inline executor* get_executor(size_t blocks) {
+	if(blocks < 2 || blocks < parallel_policy::min_blocks.load(std::memory_order_relaxed)){
+		return nullptr;
+	}
+	return parallel_policy::exec.load(std::memory_order_acquire);
+}
+
+} // namespace rhs
+
+#endif // _RHS_EXECUTOR_H_
@@ -0,0 +1,123 @@
+/**
+ * @file rhs/freshness.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Policies for skipping repeated verification of recently verified objects.
+ */
+
+#ifndef _RHS_FRESHNESS_H_
+#define _RHS_FRESHNESS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace rhs {
+
+/**
+ * Global verification epoch, see bump_epoch().
+ */
+struct verify_epoch_counter {
+	static inline std::atomic<uint64_t> value{0}; ///< Current epoch.
+};
+
+/**
+ * Current verification epoch.
+ * @return Epoch.
+ */
+inline uint64_t current_epoch() {
+	return verify_epoch_counter::value.load(std::memory_order_acquire);
+}
+
+/**
+ * Start a new verification epoch.
+ * Every object using verify_epoch or verify_window is verified again on
+ * its next access.
+ */
+inline void bump_epoch() {
+	verify_epoch_counter::value.fetch_add(1, std::memory_order_acq_rel);
+}
+
+/**
+ * Timestamp for verify_window.
+ * @return Time stamp counter on x86, steady_clock nanoseconds elsewhere.
+ */
+inline uint64_t verify_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Verify on every access.
+ */
+struct verify_always {
+	/** Whether the last verification can be reused. */
+	bool fresh() const {
+		return false;
+	}
+
+	/** Record a successful verification. */
+	void mark() const {}
+};
+
+/**
+ * Never verify on access, for objects kept correct by a scrubber.
+ */
+struct verify_scrubbed {
+	/** Whether the last verification can be reused. */
+	bool fresh() const {
+		return true;
+	}
+
+	/** Record a successful verification. */
+	void mark() const {}
+};
+
+/**
+ * Verify once per epoch.
+ * Accesses between two calls to bump_epoch() are verified only once.
+ */
+struct verify_epoch {
+	/** Whether the last verification can be reused. */
+	bool fresh() const {
+		return epoch == current_epoch();
+	}
+
+	/** Record a successful verification. */
+	void mark() const {
+		epoch = current_epoch();
+	}
+
+	mutable uint64_t epoch = UINT64_MAX; ///< Epoch of the last verification.
+};
+
+/**
+ * Verify at most once per time window, and once per epoch.
+ * @tparam Ticks Length of the window in verify_ticks() units.
+ */
+template<uint64_t Ticks>
+struct verify_window {
+	/** Whether the last verification can be reused. */
+	bool fresh() const {
+		return epoch == current_epoch() && verify_ticks() - stamp < Ticks;
+	}
+
+	/** Record a successful verification. */
+	void mark() const {
+		epoch = current_epoch();
+		stamp = verify_ticks();
+	}
+
+	mutable uint64_t epoch = UINT64_MAX; ///< Epoch of the last verification.
+	mutable uint64_t stamp = 0;          ///< Time of the last verification.
+};
+
+} // namespace rhs
+
+#endif // _RHS_FRESHNESS_H_
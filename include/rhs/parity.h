@@ -0,0 +1,310 @@
+/**
+ * @file rhs/parity.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Parity storage layouts.
+ */
+
+#ifndef _RHS_PARITY_H_
+#define _RHS_PARITY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace rhs {
+
+/**
+ * Parity stored inside the protected object, after the data.
+ */
+struct inline_parity {
+	/**
+	 * Parity bytes.
+	 * @tparam Size Parity size in bytes.
+	 */
+	template<size_t Size>
+	struct storage {
+		uint8_t* data() {
+			return bytes;
+		}
+		
+		const uint8_t* data() const {
+			return bytes;
+		}
+		
+		uint8_t bytes[Size]; ///< Parity.
+	};
+};
+
+/**
+ * Bytes per parity block in a parity_arena.
+ * Blocks smaller than a cache line are rounded up to a power of two, larger
+ * ones to whole cache lines, so no block straddles two lines.
+ * @param size Parity size in bytes.
+ * @param line Cache line size in bytes.
+ * @return Stride in bytes.
+ */
+constexpr size_t parity_stride(size_t size, size_t line = 64) {
+	if(size >= line){
+		return (size + line - 1) / line * line;
+	}
+	size_t stride = 1;
+	while(stride < size){
+		stride <<= 1;
+	}
+	return stride;
+}
+
+/**
+ * Pool of fixed-size parity blocks, allocated in cache-line-aligned slabs
+ * and never returned to the system.
+ *
+ * Blocks are named by 32-bit handles.  Each thread keeps two magazines of
+ * free blocks and only takes the arena lock to trade a whole magazine, at
+ * most once every SLAB_BLOCKS allocations or releases, or to carve a new
+ * slab.  Blocks released by a thread that exits go back to the arena.
+ * @tparam Size Parity size in bytes.
+ */
+template<size_t Size>
+class parity_arena {
+	public:
+		typedef uint32_t handle; ///< Parity block.
+		
+		enum : size_t {
+			CACHE_LINE = 64,                          ///< Alignment of slabs.
+			STRIDE = parity_stride(Size, CACHE_LINE), ///< Bytes per block.
+			SLAB_SIZE = 64*1024,                      ///< Bytes allocated at once.
+			SLAB_BLOCKS = (SLAB_SIZE > STRIDE) ? SLAB_SIZE / STRIDE : 1, ///< Blocks per slab and per magazine.
+			MAX_SLABS = 16*1024,                      ///< Maximum number of slabs.
+		};
+		
+		static_assert(Size >= sizeof(handle), "Parity must hold a free list handle");
+		
+		/**
+		 * Allocate parity.
+		 * @return Handle of uninitialized parity bytes.
+		 */
+		static handle allocate() {
+			cache& c = local();
+			if(c.loaded.count == 0){
+				if(c.spare.count > 0){
+					std::swap(c.loaded, c.spare);
+				}else{
+					c.loaded = instance().take();
+					if(c.closed){
+						// Thread is exiting, keep nothing
+						handle h = pop(c.loaded);
+						instance().put(c.loaded);
+						c.loaded = magazine();
+						return h;
+					}
+				}
+			}
+			return pop(c.loaded);
+		}
+		
+		/**
+		 * Release parity.
+		 * @param h Handle from allocate().
+		 */
+		static void release(handle h) {
+			cache& c = local();
+			if(c.closed){
+				magazine m;
+				push(m, h);
+				instance().put(m);
+				return;
+			}
+			if(c.loaded.count >= SLAB_BLOCKS){
+				if(c.spare.count > 0){
+					instance().put(c.spare);
+				}
+				c.spare = c.loaded;
+				c.loaded = magazine();
+			}
+			push(c.loaded, h);
+		}
+		
+		/**
+		 * Parity bytes of a block.
+		 * @param h Handle from allocate().
+		 * @return Pointer to the block.
+		 */
+		static uint8_t* data(handle h) {
+			uint8_t* slab = instance().slabs[h / SLAB_BLOCKS].load(std::memory_order_acquire);
+			return slab + (h % SLAB_BLOCKS)*STRIDE;
+		}
+	
+	private:
+		enum : handle {
+			NONE = ~handle(0), ///< End of a free list.
+		};
+		
+		/**
+		 * Free blocks, linked through their first bytes.
+		 */
+		struct magazine {
+			handle head = NONE; ///< First block.
+			size_t count = 0;   ///< Number of blocks.
+		};
+		
+		/**
+		 * Free blocks of one thread.
+		 */
+		struct cache {
+			magazine loaded;     ///< Blocks allocated and released first.
+			magazine spare;      ///< Full or empty magazine.
+			bool closed = false; ///< Thread is exiting, use the arena directly.
+		};
+		
+		/**
+		 * Returns a thread's blocks to the arena when it exits.
+		 */
+		struct flusher {
+			~flusher() {
+				cache& c = local();
+				instance().put(c.loaded);
+				instance().put(c.spare);
+				c = cache();
+				c.closed = true;
+			}
+		};
+		
+		/**
+		 * Arena for this size, never destroyed, so that objects with static
+		 * storage can release their parity during exit.
+		 * @return Arena.
+		 */
+		static parity_arena& instance() {
+			static parity_arena* a = new parity_arena;
+			return *a;
+		}
+		
+		/**
+		 * Free blocks of the calling thread.
+		 * @return Cache, trivially destructible so it outlives the flusher.
+		 */
+		static cache& local() {
+			static thread_local cache c;
+			static thread_local flusher f;
+			(void)f;
+			return c;
+		}
+		
+		/**
+		 * Remove a block from a magazine.
+		 * @param m Magazine, not empty.
+		 * @return Block.
+		 */
+		static handle pop(magazine& m) {
+			handle h = m.head;
+			memcpy(&m.head, data(h), sizeof(handle));
+			--m.count;
+			return h;
+		}
+		
+		/**
+		 * Add a block to a magazine.
+		 * @param m Magazine.
+		 * @param h Block.
+		 */
+		static void push(magazine& m, handle h) {
+			memcpy(data(h), &m.head, sizeof(handle));
+			m.head = h;
+			++m.count;
+		}
+		
+		/**
+		 * Take a magazine of free blocks, carving a new slab if there are none.
+		 * @return Magazine, not empty.
+		 */
+		magazine take() {
+			std::lock_guard<std::mutex> l(lock);
+			if(!full.empty()){
+				magazine m = full.back();
+				full.pop_back();
+				return m;
+			}
+			if(slab_count == MAX_SLABS){
+				throw std::bad_alloc();
+			}
+			uint8_t* slab = static_cast<uint8_t*>(::operator new(SLAB_BLOCKS*STRIDE, std::align_val_t(CACHE_LINE)));
+			const handle first = static_cast<handle>(slab_count*SLAB_BLOCKS);
+			slabs[slab_count++].store(slab, std::memory_order_release);
+			magazine m;
+			for(size_t i = SLAB_BLOCKS; i-- > 0;){
+				push(m, first + static_cast<handle>(i));
+			}
+			return m;
+		}
+		
+		/**
+		 * Return a magazine of free blocks.
+		 * @param m Magazine, ignored if empty.
+		 */
+		void put(const magazine& m) {
+			if(m.count == 0){
+				return;
+			}
+			std::lock_guard<std::mutex> l(lock);
+			full.push_back(m);
+		}
+		
+		std::mutex lock;                           ///< Protects full and slab_count.
+		std::vector<magazine> full;                ///< Magazines returned by threads.
+		size_t slab_count = 0;                     ///< Slabs carved so far.
+		std::atomic<uint8_t*> slabs[MAX_SLABS] {}; ///< Slabs, block h is in slab h / SLAB_BLOCKS.
+};
+
+/**
+ * Parity stored out of line in a parity_arena.
+ * Protected objects hold only a 32-bit handle of their parity, so arrays of
+ * them keep their data densely packed and reads that do not verify never
+ * touch parity cache lines.
+ */
+struct arena_parity {
+	/**
+	 * Parity bytes.
+	 * @tparam Size Parity size in bytes.
+	 */
+	template<size_t Size>
+	struct storage {
+		storage() :
+			index(parity_arena<Size>::allocate())
+		{}
+		
+		storage(const storage& p) :
+			index(parity_arena<Size>::allocate())
+		{
+			memcpy(data(), p.data(), Size);
+		}
+		
+		storage& operator=(const storage& p) {
+			memcpy(data(), p.data(), Size);
+			return *this;
+		}
+		
+		~storage() {
+			parity_arena<Size>::release(index);
+		}
+		
+		uint8_t* data() {
+			return parity_arena<Size>::data(index);
+		}
+		
+		const uint8_t* data() const {
+			return parity_arena<Size>::data(index);
+		}
+		
+		typename parity_arena<Size>::handle index; ///< Parity.
+	};
+};
+
+} // namespace rhs
+
+#endif // _RHS_PARITY_H_
@@ -0,0 +1,101 @@
+/**
+ * @file rhs/redundant.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Redundant execution of computations.
+ */
+
+#ifndef _RHS_REDUNDANT_H_
+#define _RHS_REDUNDANT_H_
+
+#include "edacmemory.h"
+#include "executor.h"
+#include <functional>
+#include <type_traits>
+
+namespace rhs {
+
+/**
+ * Hide an object from the optimizer.
+ * The compiler must assume the object is read and changed here, so values
+ * computed from it before are not reused after, and values stored to it are
+ * kept.
+ * @param v Object.
+ */
+template<typename V>
+inline void redundant_barrier(V& v) {
+	asm volatile("" : : "r"(&v) : "memory");
+}
+
+/**
+ * One run of a redundant computation.
+ * The function and its arguments are hidden from the optimizer before the
+ * run and the result after it, so runs of a pure function are not merged
+ * into one and the vote is not folded away.
+ * @param result Receives the result.
+ * @param f Function.
+ * @param args Arguments.
+ */
+template<typename R, typename F, typename... Args>
+inline void redundant_run(R& result, F& f, Args&... args) {
+	redundant_barrier(f);
+	(redundant_barrier(args), ...);
+	result = std::invoke(f, args...);
+	redundant_barrier(result);
+}
+
+/**
+ * Run a computation N times on the calling thread and vote on the results.
+ * An upset in registers or caches during one run changes only that run's
+ * result.  The results are voted like tmr_obj::correct(), bit by bit for
+ * results with unique object representations, and failures are reported
+ * through telemetry.
+ * @tparam N Number of runs.
+ * @param f Pure function, called N times with the same arguments.
+ * @param args Arguments.
+ * @return Voted result, or the first run's result if the vote failed.
+ */
+template<unsigned int N = 3, typename F, typename... Args, typename = std::enable_if_t<!std::is_convertible<std::decay_t<F>, executor*>::value>>
+auto redundant_invoke(F&& f, Args&&... args) {
+	typedef std::invoke_result_t<F&, Args&...> result_type;
+	static_assert(!std::is_void<result_type>::value, "Results are needed for voting");
+	tmr_obj<result_type, N> results;
+	for(unsigned int i = 0; i < N; ++i){
+		redundant_run(results[i], f, args...);
+	}
+	results.correct();
+	return results[0];
+}
+
+/**
+ * Run a computation N times in parallel and vote on the results.
+ * The runs are handed to an executor, e.g. a thread_pool kept for the life
+ * of the program, so they can run on different cores and the latency stays
+ * close to that of a single run when f is long enough to outweigh waking
+ * the workers.  A pool runs one batch at a time, so concurrent callers
+ * share it in turn.
+ * @tparam N Number of runs.
+ * @param exec Executor, or NULL to run on the calling thread.
+ * @param f Pure function, called N times with the same arguments, possibly
+ * concurrently.
+ * @param args Arguments.
+ * @return Voted result, or the first run's result if the vote failed.
+ */
+template<unsigned int N = 3, typename F, typename... Args>
+auto redundant_invoke(executor* exec, F&& f, Args&&... args) {
+	if(exec == nullptr){
+		return redundant_invoke<N>(std::forward<F>(f), std::forward<Args>(args)...);
+	}
+	typedef std::invoke_result_t<F&, Args&...> result_type;
+	static_assert(!std::is_void<result_type>::value, "Results are needed for voting");
+	tmr_obj<result_type, N> results;
+	exec->parallel_for(N, [&](size_t i) {
+		redundant_run(results[i], f, args...);
+	});
+	results.correct();
+	return results[0];
+}
+
+} // namespace rhs
+
+#endif // _RHS_REDUNDANT_H_
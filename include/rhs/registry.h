@@ -0,0 +1,299 @@
+/**
+ * @file rhs/registry.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Registry of live protected objects.
+ */
+
+#ifndef _RHS_REGISTRY_H_
+#define _RHS_REGISTRY_H_
+
+#include "error.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace rhs {
+
+/**
+ * Operations on a registered object.
+ */
+struct registry_ops {
+	rhs_error_t (*verify)(void* obj);  ///< Verify the object.
+	rhs_error_t (*correct)(void* obj); ///< Correct errors in the object.
+	size_t size;                       ///< Size of the object in bytes.
+};
+
+/**
+ * Registered object, as seen by registry::for_each().
+ */
+struct registry_entry {
+	void* obj;               ///< Object.
+	const registry_ops* ops; ///< Operations on the object.
+	
+	/** Verify the object, see registry_ops. */
+	rhs_error_t verify() const {
+		return ops->verify(obj);
+	}
+	
+	/** Correct errors in the object, see registry_ops. */
+	rhs_error_t correct() const {
+		return ops->correct(obj);
+	}
+};
+
+struct registry_shard;
+
+/**
+ * Registration of one object.
+ */
+struct registry_slot {
+	std::atomic<void*> obj{nullptr};                ///< Object, NULL while it is being removed.
+	std::atomic<const registry_ops*> ops{nullptr}; ///< Operations on the object.
+	std::atomic<uint32_t> pins{0};                  ///< Visitors using the object.
+	std::atomic<bool> used{false};                  ///< Slot is taken.
+	registry_shard* shard = nullptr;                ///< Shard owning the slot.
+};
+
+/**
+ * Fixed block of slots, never freed.
+ */
+struct registry_block {
+	enum {
+		SLOTS = 256, ///< Slots per block.
+	};
+	
+	registry_slot slots[SLOTS];                 ///< Slots.
+	std::atomic<registry_block*> next{nullptr}; ///< Next block of the shard.
+};
+
+/**
+ * Slots allocated by one thread at a time, never freed.
+ */
+struct registry_shard {
+	std::atomic<registry_block*> blocks{nullptr}; ///< Blocks, newest first.
+	std::atomic<registry_shard*> next{nullptr};   ///< Next shard.
+	std::atomic<bool> owned{true};                ///< A thread allocates from this shard.
+	registry_slot* hint = nullptr;                ///< Slot most recently freed by the owner.
+};
+
+/**
+ * Lock-free registry of live objects.
+ * Each thread allocates registrations from its own shard, so registration
+ * does not contend with other threads, and a registration removed by the
+ * thread that made it is reused by that thread's next one.  Shards of
+ * exited threads are adopted by new threads.  Removal clears the slot and
+ * then waits only for a visitor that is currently using that object.
+ */
+class registry {
+	public:
+		/**
+		 * Register an object.
+		 * @tparam P Protected type with verify() and correct().
+		 * @param obj Object to register.
+		 * @return Registration, for remove().
+		 */
+		template<typename P>
+		static registry_slot* insert(P* obj) {
+			static const registry_ops ops = {
+				[](void* p) { return static_cast<P*>(p)->verify(); },
+				[](void* p) { return static_cast<P*>(p)->correct(); },
+				sizeof(P),
+			};
+			registry_slot* slot = allocate();
+			slot->ops.store(&ops, std::memory_order_relaxed);
+			slot->obj.store(obj, std::memory_order_release);
+			return slot;
+		}
+		
+		/**
+		 * Unregister an object.
+		 * When this returns no visitor is using the object.
+		 * @param slot Registration from insert().
+		 */
+		static void remove(registry_slot* slot) {
+			slot->obj.store(nullptr, std::memory_order_seq_cst);
+			while(slot->pins.load(std::memory_order_seq_cst) != 0){
+				std::this_thread::yield();
+			}
+			slot->used.store(false, std::memory_order_release);
+			if(local().shard == slot->shard){
+				slot->shard->hint = slot;
+			}
+		}
+		
+		/**
+		 * Visit every registered object.
+		 * Each object is alive while it is visited.  Objects registered for
+		 * the whole walk are visited exactly once; objects registered or
+		 * removed during the walk may or may not be.  f must not destroy the
+		 * object it is visiting.
+		 * @param f Function to call with each registry_entry.
+		 */
+		template<typename F>
+		static void for_each(F&& f) {
+			for(registry_shard* s = shards().load(std::memory_order_acquire); s != nullptr; s = s->next.load(std::memory_order_acquire)){
+				for(registry_block* b = s->blocks.load(std::memory_order_acquire); b != nullptr; b = b->next.load(std::memory_order_acquire)){
+					for(auto& slot : b->slots){
+						if(!slot.used.load(std::memory_order_acquire)){
+							continue;
+						}
+						slot.pins.fetch_add(1, std::memory_order_seq_cst);
+						void* obj = slot.obj.load(std::memory_order_seq_cst);
+						if(obj != nullptr){
+							f(registry_entry{obj, slot.ops.load(std::memory_order_acquire)});
+						}
+						slot.pins.fetch_sub(1, std::memory_order_release);
+					}
+				}
+			}
+		}
+		
+		/**
+		 * Number of registered objects.
+		 * @return Object count.
+		 */
+		static size_t size() {
+			size_t count = 0;
+			for_each([&](const registry_entry&) { ++count; });
+			return count;
+		}
+	
+	private:
+		/**
+		 * Shard owned by the current thread, released when the thread exits.
+		 */
+		struct thread_shard {
+			registry_shard* shard = nullptr; ///< Owned shard, NULL until first use.
+			
+			~thread_shard() {
+				if(shard != nullptr){
+					shard->owned.store(false, std::memory_order_release);
+				}
+			}
+		};
+		
+		/**
+		 * All shards.
+		 * @return Head of the shard list.
+		 */
+		static std::atomic<registry_shard*>& shards() {
+			static std::atomic<registry_shard*> head{nullptr};
+			return head;
+		}
+		
+		/**
+		 * Shard of the current thread.
+		 * @return Thread's shard, which may not be allocated yet.
+		 */
+		static thread_shard& local() {
+			static thread_local thread_shard local;
+			return local;
+		}
+		
+		/**
+		 * Shard of the current thread, adopted or allocated on first use.
+		 * @return Thread's shard.
+		 */
+		static registry_shard* own_shard() {
+			thread_shard& t = local();
+			if(t.shard != nullptr){
+				return t.shard;
+			}
+			for(registry_shard* s = shards().load(std::memory_order_acquire); s != nullptr; s = s->next.load(std::memory_order_acquire)){
+				bool owned = false;
+				if(s->owned.compare_exchange_strong(owned, true, std::memory_order_acq_rel)){
+					s->hint = nullptr;
+					t.shard = s;
+					return s;
+				}
+			}
+			registry_shard* s = new registry_shard;
+			registry_shard* head = shards().load(std::memory_order_relaxed);
+			do{
+				s->next.store(head, std::memory_order_relaxed);
+			}while(!shards().compare_exchange_weak(head, s, std::memory_order_release, std::memory_order_relaxed));
+			t.shard = s;
+			return s;
+		}
+		
+		/**
+		 * Take a free slot from the current thread's shard.
+		 * Only the owner takes slots, so no other thread races to take one.
+		 * @return Slot.
+		 */
+		static registry_slot* allocate() {
+			registry_shard* s = own_shard();
+			registry_slot* slot = s->hint;
+			s->hint = nullptr;
+			if(slot == nullptr || slot->used.load(std::memory_order_acquire)){
+				slot = nullptr;
+				for(registry_block* b = s->blocks.load(std::memory_order_relaxed); b != nullptr && slot == nullptr; b = b->next.load(std::memory_order_relaxed)){
+					for(auto& candidate : b->slots){
+						if(!candidate.used.load(std::memory_order_acquire)){
+							slot = &candidate;
+							break;
+						}
+					}
+				}
+			}
+			if(slot == nullptr){
+				registry_block* b = new registry_block;
+				for(auto& candidate : b->slots){
+					candidate.shard = s;
+				}
+				b->next.store(s->blocks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				s->blocks.store(b, std::memory_order_release);
+				slot = &b->slots[0];
+			}
+			slot->used.store(true, std::memory_order_relaxed);
+			return slot;
+		}
+};
+
+/**
+ * Registry policy which does not register objects.
+ */
+struct unregistered {
+	/** Register the owning object. */
+	template<typename P>
+	void enroll(P*) {}
+	
+	/** Unregister the owning object. */
+	void leave() {}
+};
+
+/**
+ * Registry policy which registers objects in the registry.
+ * Copies are registered separately by their owner.
+ */
+struct registered {
+	registered() = default;
+	
+	registered(const registered&) {}
+	
+	registered& operator=(const registered&) {
+		return *this;
+	}
+	
+	/** Register the owning object. */
+	template<typename P>
+	void enroll(P* obj) {
+		slot = registry::insert(obj);
+	}
+	
+	/** Unregister the owning object. */
+	void leave() {
+		if(slot != nullptr){
+			registry::remove(slot);
+			slot = nullptr;
+		}
+	}
+	
+	registry_slot* slot = nullptr; ///< Registration.
+};
+
+} // namespace rhs
+
+#endif // _RHS_REGISTRY_H_
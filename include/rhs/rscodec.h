@@ -0,0 +1,475 @@
+/**
+ * @file rhs/rscodec.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Compile-time specialized Reed-Solomon codec.
+ */
+
+#ifndef _RHS_RSCODEC_H_
+#define _RHS_RSCODEC_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace rhs {
+
+/**
+ * Galois field and generator polynomial tables for rs_codec.
+ * @tparam S Symbol type.
+ * @tparam NN Symbols per block.
+ * @tparam NRoots Number of generator roots.
+ */
+template<typename S, unsigned int NN, unsigned int NRoots>
+struct rs_tables {
+	S alpha_to[2*NN];       ///< Antilog table, doubled so a sum of two logs needs no reduction.
+	S index_of[NN+1];       ///< Log table, index_of[0] is NN.
+	S genpoly[NRoots+1];    ///< Generator polynomial in index form.
+	S root[NRoots];         ///< Log of the i-th generator root, (FCR+i)*PRIM mod NN.
+	unsigned int iprim;     ///< Prim-th root of 1, index form.
+};
+
+/**
+ * Build the tables for rs_codec at compile time.
+ * @return Tables for the given code parameters.
+ */
+template<typename S, unsigned int SymBits, unsigned int GfPoly, unsigned int Fcr, unsigned int Prim, unsigned int NRoots>
+constexpr rs_tables<S, (1u << SymBits) - 1, NRoots> make_rs_tables() {
+	constexpr unsigned int NN = (1u << SymBits) - 1;
+	rs_tables<S, NN, NRoots> t{};
+
+	// Galois field lookup tables
+	t.index_of[0] = NN;
+	unsigned int sr = 1;
+	for(unsigned int i = 0; i < NN; ++i){
+		t.index_of[sr] = i;
+		t.alpha_to[i] = sr;
+		t.alpha_to[i+NN] = sr;
+		sr <<= 1;
+		if(sr & (1u << SymBits)){
+			sr ^= GfPoly;
+		}
+		sr &= NN;
+	}
+	if(sr != 1){
+		throw "Field generator polynomial is not primitive";
+	}
+
+	// Prim-th root of 1, used in decoding
+	unsigned int iprim = 1;
+	while((iprim % Prim) != 0){
+		iprim += NN;
+	}
+	t.iprim = iprim / Prim;
+
+	// Generator polynomial from its roots
+	S g[NRoots+1] = {};
+	g[0] = 1;
+	for(unsigned int i = 0, root = Fcr*Prim; i < NRoots; ++i, root += Prim){
+		g[i+1] = 1;
+		for(unsigned int j = i; j > 0; --j){
+			if(g[j] != 0){
+				g[j] = g[j-1] ^ t.alpha_to[(t.index_of[g[j]] + root) % NN];
+			}else{
+				g[j] = g[j-1];
+			}
+		}
+		g[0] = t.alpha_to[(t.index_of[g[0]] + root) % NN];
+	}
+	for(unsigned int i = 0; i <= NRoots; ++i){
+		t.genpoly[i] = t.index_of[g[i]];
+	}
+	for(unsigned int i = 0; i < NRoots; ++i){
+		t.root[i] = ((Fcr + i) * Prim) % NN;
+	}
+	return t;
+}
+
+/**
+ * Reed-Solomon codec with every code parameter fixed at compile time.
+ * The field tables and generator polynomial are built by constexpr
+ * evaluation, the loops over the parity symbols in encode(), the syndrome
+ * computation and update() are unrolled, and index sums use a doubled
+ * antilog table instead of a modular reduction loop.  decode() is not
+ * unrolled.  With 8-bit symbols it can be used as the Codec of reedsolomon
+ * and ecc_obj.  Symbols are limited to 12 bits because update() keeps a
+ * constexpr table of NN*NROOTS symbols, which grows to megabytes beyond.
+ * @tparam SymBits Bits per symbol, 2 to 12.
+ * @tparam GfPoly Field generator polynomial.
+ * @tparam Fcr First consecutive root of the code generator polynomial, index form.
+ * @tparam Prim Primitive element used to generate the roots, index form.
+ * @tparam NRoots Number of generator roots, which is the number of parity symbols.
+ */
+template<unsigned int SymBits, unsigned int GfPoly, unsigned int Fcr, unsigned int Prim, unsigned int NRoots>
+class rs_codec {
+	static_assert(SymBits >= 2 && SymBits <= 12, "Symbols must be 2 to 12 bits");
+	static_assert(Fcr < (1u << SymBits), "First consecutive root out of range");
+	static_assert(Prim > 0 && Prim < (1u << SymBits), "Primitive element out of range");
+	static_assert(NRoots > 0 && NRoots < (1u << SymBits) - 1, "Too many roots");
+
+	public:
+		typedef typename std::conditional<(SymBits <= 8), uint8_t, uint16_t>::type symbol_t; ///< Symbol type.
+
+		enum : unsigned int {
+			NN = (1u << SymBits) - 1, ///< Symbols per block.
+			NROOTS = NRoots,          ///< Parity symbols per block.
+		};
+
+		/**
+		 * Encode a block.
+		 * @param data NN-NROOTS-pad data symbols.
+		 * @param parity NROOTS parity symbols to write.
+		 * @param pad Number of virtual leading zero symbols.
+		 */
+		static void encode(symbol_t* data, symbol_t* parity, int pad) {
+			symbol_t reg[NRoots] = {};
+			for(int i = 0; i < static_cast<int>(NN - NRoots) - pad; ++i){
+				step(reg, tables.index_of[data[i] ^ reg[0]]);
+			}
+			for(unsigned int i = 0; i < NRoots; ++i){
+				parity[i] = reg[i];
+			}
+		}
+
+		/**
+		 * Decode and correct a block in place.
+		 * @param data NN-pad data and parity symbols.
+		 * @param eras_pos Erasure positions on input, error positions on output, or NULL.
+		 * @param no_eras Number of erasures.
+		 * @param pad Number of virtual leading zero symbols.
+		 * @return Number of corrected symbols, or -1 if uncorrectable.
+		 */
+		static int decode(symbol_t* data, int* eras_pos, int no_eras, int pad) {
+			if(pad < 0 || pad >= static_cast<int>(NN - NRoots)){
+				return -1;
+			}
+
+			unsigned int s[NRoots];
+			if(syndromes(data, static_cast<int>(NN - NRoots) - pad, &data[NN-NRoots-pad], s) == 0){
+				// data[] is a codeword
+				return 0;
+			}
+			for(unsigned int i = 0; i < NRoots; ++i){
+				s[i] = tables.index_of[s[i]];
+			}
+
+			// Erasure locator polynomial
+			unsigned int lambda[NRoots+1] = {};
+			lambda[0] = 1;
+			if(no_eras > 0){
+				lambda[1] = tables.alpha_to[modnn(Prim*(NN-1-eras_pos[0]))];
+				for(int i = 1; i < no_eras; ++i){
+					unsigned int u = modnn(Prim*(NN-1-eras_pos[i]));
+					for(int j = i+1; j > 0; --j){
+						unsigned int tmp = tables.index_of[lambda[j-1]];
+						if(tmp != A0){
+							lambda[j] ^= tables.alpha_to[u + tmp];
+						}
+					}
+				}
+			}
+			unsigned int b[NRoots+1];
+			for(unsigned int i = 0; i <= NRoots; ++i){
+				b[i] = tables.index_of[lambda[i]];
+			}
+
+			// Berlekamp-Massey algorithm to determine the error+erasure locator polynomial
+			int el = no_eras;
+			for(int r = no_eras + 1; r <= static_cast<int>(NRoots); ++r){
+				unsigned int discr_r = 0;
+				for(int i = 0; i < r; ++i){
+					if(lambda[i] != 0 && s[r-i-1] != A0){
+						discr_r ^= tables.alpha_to[tables.index_of[lambda[i]] + s[r-i-1]];
+					}
+				}
+				discr_r = tables.index_of[discr_r];
+				if(discr_r == A0){
+					shift_up(b);
+				}else{
+					unsigned int t[NRoots+1];
+					t[0] = lambda[0];
+					for(unsigned int i = 0; i < NRoots; ++i){
+						t[i+1] = (b[i] != A0) ? (lambda[i+1] ^ tables.alpha_to[discr_r + b[i]]) : lambda[i+1];
+					}
+					if(2*el <= r + no_eras - 1){
+						el = r + no_eras - el;
+						for(unsigned int i = 0; i <= NRoots; ++i){
+							b[i] = (lambda[i] == 0) ? A0 : modnn(tables.index_of[lambda[i]] - discr_r + NN);
+						}
+					}else{
+						shift_up(b);
+					}
+					for(unsigned int i = 0; i <= NRoots; ++i){
+						lambda[i] = t[i];
+					}
+				}
+			}
+
+			// Convert lambda to index form and compute deg(lambda(x))
+			int deg_lambda = 0;
+			for(unsigned int i = 0; i <= NRoots; ++i){
+				lambda[i] = tables.index_of[lambda[i]];
+				if(lambda[i] != A0){
+					deg_lambda = i;
+				}
+			}
+
+			// Chien search for the roots of lambda(x)
+			unsigned int reg[NRoots+1];
+			unsigned int root[NRoots];
+			unsigned int loc[NRoots];
+			int count = 0;
+			for(unsigned int i = 1; i <= NRoots; ++i){
+				reg[i] = lambda[i];
+			}
+			for(unsigned int i = 1, k = tables.iprim-1; i <= NN; ++i, k = modnn(k + tables.iprim)){
+				unsigned int q = 1;
+				for(int j = deg_lambda; j > 0; --j){
+					if(reg[j] != A0){
+						reg[j] = modnn(reg[j] + j);
+						q ^= tables.alpha_to[reg[j]];
+					}
+				}
+				if(q != 0){
+					continue;
+				}
+				root[count] = i;
+				loc[count] = k;
+				if(++count == deg_lambda){
+					break;
+				}
+			}
+			if(deg_lambda != count){
+				// deg(lambda) unequal to number of roots, uncorrectable error detected
+				return -1;
+			}
+
+			// Error evaluator polynomial omega(x) = s(x)*lambda(x) mod x**NROOTS
+			int deg_omega = deg_lambda - 1;
+			unsigned int omega[NRoots+1];
+			for(int i = 0; i <= deg_omega; ++i){
+				unsigned int tmp = 0;
+				for(int j = i; j >= 0; --j){
+					if(s[i-j] != A0 && lambda[j] != A0){
+						tmp ^= tables.alpha_to[s[i-j] + lambda[j]];
+					}
+				}
+				omega[i] = tables.index_of[tmp];
+			}
+
+			// Forney algorithm for the error values
+			for(int j = count-1; j >= 0; --j){
+				unsigned int num1 = 0;
+				for(int i = deg_omega; i >= 0; --i){
+					if(omega[i] != A0){
+						num1 ^= tables.alpha_to[modnn(omega[i] + i * root[j])];
+					}
+				}
+				unsigned int num2 = tables.alpha_to[modnn(root[j] * modnn(Fcr + NN - 1))];
+				unsigned int den = 0;
+				// lambda[i+1] for i even is the formal derivative lambda_pr of lambda[i]
+				for(int i = ((deg_lambda < static_cast<int>(NRoots-1)) ? deg_lambda : NRoots-1) & ~1; i >= 0; i -= 2){
+					if(lambda[i+1] != A0){
+						den ^= tables.alpha_to[modnn(lambda[i+1] + i * root[j])];
+					}
+				}
+				if(num1 != 0 && loc[j] >= static_cast<unsigned int>(pad)){
+					data[loc[j]-pad] ^= tables.alpha_to[modnn(tables.index_of[num1] + tables.index_of[num2] + NN - tables.index_of[den])];
+				}
+			}
+			if(eras_pos != nullptr){
+				for(int i = 0; i < count; ++i){
+					eras_pos[i] = loc[i];
+				}
+			}
+			return count;
+		}
+
+		/**
+		 * Check a block without decoding.
+		 * @param data NN-NROOTS-pad data symbols.
+		 * @param parity NROOTS parity symbols.
+		 * @param pad Number of virtual leading zero symbols.
+		 * @return 0 if the block is a codeword, nonzero otherwise.
+		 */
+		static int check(symbol_t* data, symbol_t* parity, int pad) {
+			if(pad < 0 || pad >= static_cast<int>(NN - NRoots)){
+				return -1;
+			}
+			unsigned int s[NRoots];
+			return syndromes(data, static_cast<int>(NN - NRoots) - pad, parity, s) != 0;
+		}
+
+		/**
+		 * Check many blocks without decoding.
+		 * @param data Data symbols of each block.
+		 * @param parity Parity symbols of each block, or NULL if they follow the data.
+		 * @param count Number of blocks.
+		 * @param pad Number of virtual leading zero symbols in every block.
+		 * @param result If not NULL, receives check() of each block.
+		 * @return Number of blocks that are not codewords, or -1 on bad arguments.
+		 */
+		static int check_batch(symbol_t** data, symbol_t** parity, int count, int pad, int* result) {
+			if(pad < 0 || pad >= static_cast<int>(NN - NRoots)){
+				return -1;
+			}
+			int errors = 0;
+			for(int i = 0; i < count; ++i){
+				symbol_t* p = (parity != nullptr) ? parity[i] : &data[i][NN-NRoots-pad];
+				int r = check(data[i], p, pad);
+				if(result != nullptr){
+					result[i] = r;
+				}
+				if(r != 0){
+					++errors;
+				}
+			}
+			return errors;
+		}
+
+		/**
+		 * Update parity after data symbols were XORed with a delta.
+		 * @param parity NROOTS parity symbols to update.
+		 * @param pos Index of the first changed data symbol.
+		 * @param delta XOR of the old and new data symbols.
+		 * @param len Number of changed symbols.
+		 * @param pad Number of virtual leading zero symbols.
+		 * @return 0 on success, -1 on bad arguments.
+		 */
+		static int update(symbol_t* parity, int pos, symbol_t* delta, int len, int pad) {
+			static constexpr unit_table units = make_units();
+			if(pad < 0 || pos < 0 || len < 0 || pos + len > static_cast<int>(NN - NRoots) - pad){
+				return -1;
+			}
+			for(int j = 0; j < len; ++j){
+				unsigned int d = tables.index_of[delta[j]];
+				if(d == A0){
+					// Unchanged symbol
+					continue;
+				}
+				const unsigned int* unit = units.log[pad+pos+j];
+				unroll([&](auto i) {
+					if(unit[i] != A0){
+						parity[i] ^= tables.alpha_to[d + unit[i]];
+					}
+				}, std::make_index_sequence<NRoots>());
+			}
+			return 0;
+		}
+
+	private:
+		static constexpr unsigned int A0 = NN; ///< Index form of zero.
+		static constexpr rs_tables<symbol_t, NN, NRoots> tables = make_rs_tables<symbol_t, SymBits, GfPoly, Fcr, Prim, NRoots>(); ///< Field tables.
+
+		/**
+		 * Parity of each unit data vector in index form.
+		 */
+		struct unit_table {
+			unsigned int log[NN-NRoots][NRoots]; ///< log[j][i] is parity symbol i of the unit vector at position j.
+		};
+
+		/**
+		 * Reduce modulo NN.
+		 * @param x Value to reduce.
+		 * @return x mod NN.
+		 */
+		static constexpr unsigned int modnn(unsigned int x) {
+			return x % NN;
+		}
+
+		/**
+		 * Call f with each index as an integral constant.
+		 * @param f Function to call.
+		 */
+		template<typename F, size_t... I>
+		static void unroll(F&& f, std::index_sequence<I...>) {
+			(f(std::integral_constant<size_t, I>()), ...);
+		}
+
+		/**
+		 * Multiply a polynomial in index form by x.
+		 * @param b Polynomial to shift.
+		 */
+		static void shift_up(unsigned int (&b)[NRoots+1]) {
+			for(unsigned int i = NRoots; i > 0; --i){
+				b[i] = b[i-1];
+			}
+			b[0] = A0;
+		}
+
+		/**
+		 * Advance the encoder shift register by one symbol.
+		 * @param reg Parity shift register.
+		 * @param feedback Feedback symbol in index form.
+		 */
+		static void step(symbol_t (&reg)[NRoots], unsigned int feedback) {
+			if(feedback != A0){
+				unroll([&](auto j) {
+					constexpr unsigned int g = tables.genpoly[NRoots-1-j];
+					if constexpr(j < NRoots-1){
+						reg[j] = reg[j+1] ^ ((g != A0) ? tables.alpha_to[feedback + g] : 0);
+					}else{
+						reg[j] = (g != A0) ? tables.alpha_to[feedback + g] : 0;
+					}
+				}, std::make_index_sequence<NRoots>());
+			}else{
+				for(unsigned int j = 0; j < NRoots-1; ++j){
+					reg[j] = reg[j+1];
+				}
+				reg[NRoots-1] = 0;
+			}
+		}
+
+		/**
+		 * Evaluate data followed by parity at the roots of the generator polynomial.
+		 * @param data Data symbols.
+		 * @param len Number of data symbols.
+		 * @param parity NROOTS parity symbols.
+		 * @param s Syndromes in polynomial form.
+		 * @return Nonzero if any syndrome is nonzero.
+		 */
+		static unsigned int syndromes(const symbol_t* data, int len, const symbol_t* parity, unsigned int (&s)[NRoots]) {
+			for(unsigned int i = 0; i < NRoots; ++i){
+				s[i] = 0;
+			}
+			for(int j = 0; j < len + static_cast<int>(NRoots); ++j){
+				symbol_t x = (j < len) ? data[j] : parity[j-len];
+				unroll([&](auto i) {
+					s[i] = x ^ ((s[i] != 0) ? tables.alpha_to[tables.index_of[s[i]] + tables.root[i]] : 0);
+				}, std::make_index_sequence<NRoots>());
+			}
+			unsigned int syn_error = 0;
+			for(unsigned int i = 0; i < NRoots; ++i){
+				syn_error |= s[i];
+			}
+			return syn_error;
+		}
+
+		/**
+		 * Build the parity of every unit data vector.
+		 * @return Unit vector parity table.
+		 */
+		static constexpr unit_table make_units() {
+			unit_table u{};
+			unsigned int p[NRoots] = {};
+			// The last position is one encoder step with feedback 1,
+			// each earlier one is followed by one more step with zero input
+			for(int j = NN-NRoots-1; j >= 0; --j){
+				unsigned int feedback = (j == static_cast<int>(NN-NRoots-1)) ? 0 : tables.index_of[p[0]];
+				for(unsigned int i = 0; i < NRoots; ++i){
+					unsigned int next = (i < NRoots-1) ? p[i+1] : 0;
+					unsigned int g = tables.genpoly[NRoots-1-i];
+					p[i] = next ^ ((feedback != A0 && g != A0) ? tables.alpha_to[feedback + g] : 0);
+				}
+				for(unsigned int i = 0; i < NRoots; ++i){
+					u.log[j][i] = tables.index_of[p[i]];
+				}
+			}
+			return u;
+		}
+};
+
+} // namespace rhs
+
+#endif // _RHS_RSCODEC_H_
@@ -0,0 +1,281 @@
+/**
+ * @file rhs/scrubber.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Background verification and correction of protected objects.
+ */
+
+#ifndef _RHS_SCRUBBER_H_
+#define _RHS_SCRUBBER_H_
+
+#include "error.h"
+#include "registry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rhs {
+
+/**
+ * Memory scrubber.
+ * Registered objects are verified and corrected in the background, a few
+ * at a time, so that upsets are repaired before they accumulate in objects
+ * that are rarely accessed.  Combined with the verify_scrubbed policy,
+ * ecc_obj accessors do no verification at all.
+ *
+ * A scrubber either scrubs the objects passed to add(), or, in REGISTRY
+ * mode, every object in rhs::registry, i.e. every live object with the
+ * registered policy.  The registry is walked from the start at every step
+ * to find the next batch.
+ *
+ * The scrubber holds its lock while it scrubs an object.  Code that writes
+ * registered objects from other threads must hold the lock too, e.g. with
+ * std::lock_guard<rhs::scrubber>, so that a half-written object is not
+ * "corrected" back to its old value.
+ */
+class scrubber {
+	public:
+		/**
+		 * Objects to scrub.
+		 */
+		enum source {
+			ADDED,    ///< Objects passed to add().
+			REGISTRY, ///< Objects in rhs::registry.
+		};
+		
+		/**
+		 * Constructor, starts the scrubber thread.
+		 * @param interval Time between steps.
+		 * @param batch Objects scrubbed per step, at most one pass.
+		 * @param objects Objects to scrub, ADDED or REGISTRY.
+		 */
+		explicit scrubber(std::chrono::nanoseconds interval = std::chrono::milliseconds(10), size_t batch = 16, source objects = ADDED) :
+			interval(interval),
+			batch(batch),
+			mode(objects)
+		{
+			thread = std::thread(&scrubber::run, this);
+		}
+		
+		/**
+		 * Destructor, stops the scrubber thread.
+		 */
+		~scrubber() {
+			{
+				std::lock_guard<std::mutex> l(mutex);
+				stop = true;
+			}
+			wake.notify_one();
+			thread.join();
+		}
+		
+		scrubber(const scrubber&) = delete;
+		scrubber& operator=(const scrubber&) = delete;
+		
+		/**
+		 * Register an object, ignored in REGISTRY mode.
+		 * @tparam P Protected type with verify() and correct(), e.g. ecc_obj or tmr_obj.
+		 * @param obj Object to scrub, must be removed before it is destroyed.
+		 */
+		template<typename P>
+		void add(P& obj) {
+			std::lock_guard<std::mutex> l(mutex);
+			objects.push_back({&obj, &scrubber::scrub_entry<P>});
+		}
+		
+		/**
+		 * Unregister an object.
+		 * When this returns the object is not being scrubbed.
+		 * @tparam P Protected type.
+		 * @param obj Object to stop scrubbing.
+		 */
+		template<typename P>
+		void remove(P& obj) {
+			std::lock_guard<std::mutex> l(mutex);
+			for(size_t i = 0; i < objects.size(); ++i){
+				if(objects[i].obj == &obj){
+					objects[i] = objects.back();
+					objects.pop_back();
+					return;
+				}
+			}
+		}
+		
+		/**
+		 * Scrub every registered object now.
+		 */
+		void scrub_all() {
+			std::lock_guard<std::mutex> l(mutex);
+			if(mode == REGISTRY){
+				registry::for_each([this](const registry_entry& e) {
+					tally(scrub_one(e));
+				});
+			}else{
+				for(size_t i = 0; i < objects.size(); ++i){
+					tally(objects[i].scrub(objects[i].obj));
+				}
+			}
+			++pass_count;
+		}
+		
+		/**
+		 * Lock out the scrubber while registered objects are written.
+		 */
+		void lock() {
+			mutex.lock();
+		}
+		
+		/**
+		 * Let the scrubber run again.
+		 */
+		void unlock() {
+			mutex.unlock();
+		}
+		
+		/**
+		 * Number of complete passes over the registered objects.
+		 * @return Pass count.
+		 */
+		size_t passes() const {
+			return pass_count;
+		}
+		
+		/**
+		 * Number of objects found with errors.
+		 * @return Error count.
+		 */
+		size_t errors() const {
+			return error_count;
+		}
+		
+		/**
+		 * Number of objects whose errors could not be corrected.
+		 * @return Failure count.
+		 */
+		size_t failures() const {
+			return failure_count;
+		}
+	
+	private:
+		/**
+		 * Registered object.
+		 */
+		struct entry {
+			void* obj;                       ///< Object to scrub.
+			rhs_error_t (*scrub)(void* obj); ///< Verify and correct the object.
+		};
+		
+		/**
+		 * Verify and correct an object.
+		 * @tparam P Protected type, or registry_entry.
+		 * @param p Object to scrub.
+		 * @return Error code of verify(), or of correct() if verify() failed.
+		 */
+		template<typename P>
+		static rhs_error_t scrub_one(P& p) {
+			rhs_error_t ret = p.verify();
+			if(ret == RHS_ENOTVERIFIED){
+				rhs_error_t corr = p.correct();
+				if(corr == RHS_ENOTCORRECTED){
+					ret = corr;
+				}
+			}
+			return ret;
+		}
+		
+		/**
+		 * Verify and correct an object passed to add().
+		 * @tparam P Protected type.
+		 * @param obj Object to scrub.
+		 * @return Error code, see scrub_one().
+		 */
+		template<typename P>
+		static rhs_error_t scrub_entry(void* obj) {
+			return scrub_one(*static_cast<P*>(obj));
+		}
+		
+		/**
+		 * Count the result of scrubbing an object, with the lock held.
+		 * @param r Error code from scrub_one().
+		 */
+		void tally(rhs_error_t r) {
+			if(r != RHS_EOK){
+				++error_count;
+			}
+			if(r == RHS_ENOTCORRECTED){
+				++failure_count;
+			}
+		}
+		
+		/**
+		 * Scrub the next batch of objects passed to add(), with the lock held.
+		 */
+		void step_added() {
+			size_t count = std::min(batch, objects.size());
+			for(size_t i = 0; i < count; ++i){
+				if(cursor >= objects.size()){
+					cursor = 0;
+					++pass_count;
+				}
+				const entry& e = objects[cursor++];
+				tally(e.scrub(e.obj));
+			}
+		}
+		
+		/**
+		 * Scrub the next batch of objects in the registry, with the lock held.
+		 * A pass ends when the walk runs out of objects.
+		 */
+		void step_registry() {
+			size_t index = 0;
+			size_t count = 0;
+			registry::for_each([&](const registry_entry& e) {
+				if(index++ >= cursor && count < batch){
+					tally(scrub_one(e));
+					++count;
+				}
+			});
+			cursor += count;
+			if(count < batch && index > 0){
+				cursor = 0;
+				++pass_count;
+			}
+		}
+		
+		/**
+		 * Scrubber thread body.
+		 */
+		void run() {
+			std::unique_lock<std::mutex> l(mutex);
+			while(!stop){
+				if(mode == REGISTRY){
+					step_registry();
+				}else{
+					step_added();
+				}
+				wake.wait_for(l, interval, [this]() { return stop; });
+			}
+		}
+		
+		const std::chrono::nanoseconds interval; ///< Time between steps.
+		const size_t batch;                      ///< Objects scrubbed per step.
+		const source mode;                       ///< Objects to scrub.
+		std::vector<entry> objects;              ///< Registered objects.
+		size_t cursor = 0;                       ///< Next object to scrub.
+		std::atomic<size_t> pass_count{0};       ///< Complete passes.
+		std::atomic<size_t> error_count{0};      ///< Objects found with errors.
+		std::atomic<size_t> failure_count{0};    ///< Objects that could not be corrected.
+		bool stop = false;                       ///< Stop the thread.
+		std::mutex mutex;                        ///< Protects the objects.
+		std::condition_variable wake;            ///< Signals stop.
+		std::thread thread;                      ///< Scrubber thread.
+};
+
+} // namespace rhs
+
+#endif // _RHS_SCRUBBER_H_
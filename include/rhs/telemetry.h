@@ -0,0 +1,277 @@
+/**
+ * @file rhs/telemetry.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Reporting of detected and corrected errors.
+ */
+
+#ifndef _RHS_TELEMETRY_H_
+#define _RHS_TELEMETRY_H_
+
+#include "freshness.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace rhs {
+
+/**
+ * Kind of event.
+ */
+enum event_type {
+	EVENT_NOTVERIFIED = 0, ///< Verification failed.
+	EVENT_CORRECTED,       ///< Errors were corrected.
+	EVENT_NOTCORRECTED,    ///< Correction failed.
+	EVENT_TYPES,           ///< Number of event types.
+};
+
+/**
+ * Detected or corrected error.
+ */
+struct event {
+	event_type type; ///< Kind of event.
+	const void* obj; ///< Protected object.
+	int block;       ///< Codeword in the object, -1 if not applicable.
+	int symbols;     ///< Symbols corrected, 0 if unknown.
+	uint64_t time;   ///< Time in verify_ticks() units.
+};
+
+/**
+ * Receives events.
+ * record() is called from the thread that found the error and must not
+ * block or allocate.
+ */
+class event_sink {
+	public:
+		/**
+		 * Destructor.
+		 */
+		virtual ~event_sink() = default;
+		
+		/**
+		 * Record an event.
+		 * @param e Event.
+		 */
+		virtual void record(const event& e) = 0;
+};
+
+/**
+ * Default sink, with counters per event type and a bounded lock-free ring
+ * of the most recent events.  When the ring is full new events are counted
+ * but dropped until a monitoring thread drains it.
+ *
+ * Each thread counts in its own cache line, claimed on its first event and
+ * given back when it exits; count() sums them.  Beyond THREADS live threads,
+ * the extra threads share counter blocks.
+ */
+class event_ring : public event_sink {
+	public:
+		enum {
+			CAPACITY = 1024, ///< Events held until drained, a power of two.
+			THREADS = 64,    ///< Counter blocks, one per live thread.
+		};
+		
+		/**
+		 * Constructor.
+		 */
+		event_ring() {
+			for(size_t i = 0; i < CAPACITY; ++i){
+				cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+		}
+		
+		void record(const event& e) override {
+			blocks[thread_block()].counts[e.type].fetch_add(1, std::memory_order_relaxed);
+			size_t pos = head.load(std::memory_order_relaxed);
+			cell* c;
+			for(;;){
+				c = &cells[pos & (CAPACITY-1)];
+				intptr_t diff = static_cast<intptr_t>(c->seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+				if(diff == 0){
+					if(head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+						break;
+					}
+				}else if(diff < 0){
+					// Full
+					lost.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}else{
+					pos = head.load(std::memory_order_relaxed);
+				}
+			}
+			c->e = e;
+			c->seq.store(pos + 1, std::memory_order_release);
+		}
+		
+		/**
+		 * Remove events from the ring, oldest first.
+		 * @param out Receives the events.
+		 * @param max Maximum number of events.
+		 * @return Number of events removed.
+		 */
+		size_t drain(event* out, size_t max) {
+			size_t n = 0;
+			size_t pos = tail.load(std::memory_order_relaxed);
+			while(n < max){
+				cell* c = &cells[pos & (CAPACITY-1)];
+				intptr_t diff = static_cast<intptr_t>(c->seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos + 1);
+				if(diff == 0){
+					if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+						out[n++] = c->e;
+						c->seq.store(pos + CAPACITY, std::memory_order_release);
+						++pos;
+					}
+				}else if(diff < 0){
+					// Empty
+					break;
+				}else{
+					pos = tail.load(std::memory_order_relaxed);
+				}
+			}
+			return n;
+		}
+		
+		/**
+		 * Number of events of a type recorded, including dropped ones.
+		 * @param type Event type.
+		 * @return Event count.
+		 */
+		uint64_t count(event_type type) const {
+			uint64_t n = 0;
+			for(const auto& b : blocks){
+				n += b.counts[type].load(std::memory_order_relaxed);
+			}
+			return n;
+		}
+		
+		/**
+		 * Number of events dropped because the ring was full.
+		 * @return Event count.
+		 */
+		uint64_t dropped() const {
+			return lost.load(std::memory_order_relaxed);
+		}
+	
+	private:
+		/**
+		 * Slot of the ring.
+		 */
+		struct cell {
+			std::atomic<size_t> seq; ///< Position the cell is ready for.
+			event e;                 ///< Event.
+		};
+		
+		/**
+		 * Counters of one thread, on their own cache line.
+		 */
+		struct alignas(64) counter_block {
+			std::atomic<uint64_t> counts[EVENT_TYPES] = {}; ///< Events per type.
+		};
+		
+		/**
+		 * Counter block index held by a thread until it exits.
+		 */
+		struct thread_slot {
+			/**
+			 * Constructor, claims a free index, or shares one if every
+			 * index is held.
+			 */
+			thread_slot() {
+				uint64_t held = in_use().load(std::memory_order_relaxed);
+				while(~held != 0){
+					size_t free = __builtin_ctzll(~held);
+					if(in_use().compare_exchange_weak(held, held | (uint64_t(1) << free), std::memory_order_relaxed)){
+						index = free;
+						owned = true;
+						return;
+					}
+				}
+				index = std::hash<std::thread::id>()(std::this_thread::get_id()) % THREADS;
+			}
+			
+			/**
+			 * Destructor, gives the index back.  The counts stay in the
+			 * block and the next thread to claim it adds to them.
+			 */
+			~thread_slot() {
+				if(owned){
+					in_use().fetch_and(~(uint64_t(1) << index), std::memory_order_relaxed);
+				}
+			}
+			
+			size_t index;       ///< Counter block index.
+			bool owned = false; ///< Whether the index was claimed.
+		};
+		
+		static_assert(THREADS == 64, "Block indices are claimed in a 64-bit mask");
+		
+		/**
+		 * Counter block indices held by live threads.
+		 * @return Bit mask of held indices.
+		 */
+		static std::atomic<uint64_t>& in_use() {
+			static std::atomic<uint64_t> mask{0};
+			return mask;
+		}
+		
+		/**
+		 * Counter block of the current thread, the same in every ring.
+		 * @return Block index.
+		 */
+		static size_t thread_block() {
+			static thread_local thread_slot slot;
+			return slot.index;
+		}
+		
+		cell cells[CAPACITY];                      ///< Ring.
+		alignas(64) std::atomic<size_t> head{0};   ///< Next position to write.
+		alignas(64) std::atomic<size_t> tail{0};   ///< Next position to drain.
+		std::atomic<uint64_t> lost{0};             ///< Events dropped.
+		counter_block blocks[THREADS];             ///< Event counters per thread.
+};
+
+/**
+ * Event sink used by the library.
+ */
+struct telemetry {
+	/**
+	 * Built-in sink.
+	 * @return Default event_ring.
+	 */
+	static event_ring& ring() {
+		static event_ring r;
+		return r;
+	}
+	
+	static inline std::atomic<event_sink*> sink{nullptr}; ///< Installed sink, NULL for ring().
+};
+
+/**
+ * Install an event sink.
+ * @param sink Sink, or NULL for the built-in event_ring.
+ */
+inline void set_event_sink(event_sink* sink) {
+	telemetry::sink.store(sink, std::memory_order_release);
+}
+
+/**
+ * Report an event to the installed sink.
+ * @param type Kind of event.
+ * @param obj Protected object.
+ * @param block Codeword in the object, -1 if not applicable.
+ * @param symbols Symbols corrected, 0 if unknown.
+ */
+inline void report(event_type type, const void* obj, int block = -1, int symbols = 0) {
+	event e = {type, obj, block, symbols, verify_ticks()};
+	event_sink* sink = telemetry::sink.load(std::memory_order_acquire);
+	if(sink == nullptr){
+		sink = &telemetry::ring();
+	}
+	sink->record(e);
+}
+
+} // namespace rhs
+
+#endif // _RHS_TELEMETRY_H_
@@ -0,0 +1,302 @@
+/**
+ * @file rhs/tmrarray.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Redundant array with each copy stored contiguously.
+ */
+
+#ifndef _RHS_TMRARRAY_H_
+#define _RHS_TMRARRAY_H_
+
+#include "error.h"
+#include "registry.h"
+#include "telemetry.h"
+#include "vote.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace rhs {
+
+/**
+ * Redundant array.
+ * Unlike an array of tmr_obj, which keeps the copies of each element next
+ * to each other, every copy of the array is stored contiguously, aligned to
+ * a cache line or optionally to its own pages.  Verifying the whole array
+ * is then N streaming passes, and correction votes bit by bit with vote.h,
+ * a few kilobytes at a time.  Element reads vote the N copies of the
+ * element, found at a fixed stride.  Every copy of an element is written
+ * from the same bytes, padding included, so bitwise voting is sound even
+ * for element types with padding.
+ * @tparam T Type of elements, trivially copyable.
+ * @tparam N Number of redundant copies.
+ * @tparam Reg Registry policy, unregistered or registered.
+ */
+template<typename T, unsigned int N = 3, typename Reg = unregistered>
+class tmr_array : private Reg {
+	static_assert(std::is_trivially_copyable<T>::value, "Elements must be trivially copyable");
+	
+	public:
+		enum {
+			CACHE_LINE = 64, ///< Default alignment of each copy.
+			CHUNK = 4096,    ///< Bytes voted at once by correct().
+		};
+		
+		/**
+		 * Constructor.
+		 * @param count Number of elements.
+		 * @param value Initial value of every element.
+		 * @param separate_pages Put each copy on its own pages, so that an
+		 * upset corrupting a whole page affects only one copy.
+		 */
+		explicit tmr_array(size_t count = 0, const T& value = T(), bool separate_pages = false) :
+			count(count),
+			align(separate_pages ? static_cast<size_t>(sysconf(_SC_PAGESIZE)) : static_cast<size_t>(CACHE_LINE))
+		{
+			allocate();
+			for(size_t i = 0; i < count; ++i){
+				memcpy(base + i*sizeof(T), &value, sizeof(T));
+			}
+			for(unsigned int c = 1; c < N; ++c){
+				memcpy(base + c*stride, base, count*sizeof(T));
+			}
+			Reg::enroll(this);
+		}
+		
+		/**
+		 * Copy constructor.
+		 * @param p Original array.
+		 */
+		tmr_array(const tmr_array& p) :
+			Reg(p),
+			count(p.count),
+			align(p.align)
+		{
+			allocate();
+			if(base != nullptr){
+				memcpy(base, p.base, N*stride);
+			}
+			Reg::enroll(this);
+		}
+		
+		/**
+		 * Copy assignment.
+		 * The copies are made before the old ones are freed, so the array is
+		 * unchanged if the allocation throws.
+		 * @param p Original array.
+		 * @return This array.
+		 */
+		tmr_array& operator=(const tmr_array& p) {
+			if(this != &p){
+				tmr_array copy(p);
+				swap(copy);
+			}
+			return *this;
+		}
+		
+		/**
+		 * Destructor.
+		 */
+		~tmr_array() {
+			Reg::leave();
+			release();
+		}
+		
+		/**
+		 * Number of elements.
+		 * @return Element count.
+		 */
+		size_t size() const {
+			return count;
+		}
+		
+		/**
+		 * Whether the array has no elements.
+		 * @return true if size() is 0.
+		 */
+		bool empty() const {
+			return count == 0;
+		}
+		
+		/**
+		 * Read an element, correcting its copies if they disagree.
+		 * @param i Index.
+		 * @return Voted element.
+		 */
+		T operator[](size_t i) {
+			uint8_t* copies[N];
+			element(i, copies);
+			if(!same_bytes<N>(copies, sizeof(T))){
+				int changed = vote_bytes<N>(copies, sizeof(T));
+				if(changed < 0){
+					report(EVENT_NOTCORRECTED, this, static_cast<int>(i));
+				}else{
+					report(EVENT_CORRECTED, this, static_cast<int>(i), changed);
+				}
+			}
+			T ret;
+			memcpy(&ret, copies[0], sizeof(T));
+			return ret;
+		}
+		
+		/**
+		 * Read an element without correcting it.
+		 * @param i Index.
+		 * @return Voted element.
+		 */
+		T operator[](size_t i) const {
+			uint8_t* copies[N];
+			element(i, copies);
+			T tmp[N];
+			uint8_t* votes[N];
+			for(unsigned int c = 0; c < N; ++c){
+				memcpy(&tmp[c], copies[c], sizeof(T));
+				votes[c] = reinterpret_cast<uint8_t*>(&tmp[c]);
+			}
+			vote_bytes<N>(votes, sizeof(T));
+			return tmp[0];
+		}
+		
+		/**
+		 * Write an element to every copy.
+		 * @param i Index.
+		 * @param value New value.
+		 */
+		void set(size_t i, const T& value) {
+			uint8_t* copies[N];
+			element(i, copies);
+			for(unsigned int c = 0; c < N; ++c){
+				memcpy(copies[c], &value, sizeof(T));
+			}
+		}
+		
+		/**
+		 * Copy of the array.
+		 * @param c Copy index.
+		 * @return Elements of copy c.
+		 * @note For testing only.
+		 */
+		T* replica(unsigned int c) {
+			return reinterpret_cast<T*>(base + c*stride);
+		}
+		
+		/**
+		 * Copy of the array.
+		 * @param c Copy index.
+		 * @return Elements of copy c.
+		 */
+		const T* replica(unsigned int c) const {
+			return reinterpret_cast<const T*>(base + c*stride);
+		}
+		
+		/**
+		 * Verify the integrity of the array.
+		 * @return RHS_EOK if every copy matches.
+		 */
+		rhs_error_t verify() {
+			const uint8_t* copies[N];
+			for(unsigned int c = 0; c < N; ++c){
+				copies[c] = base + c*stride;
+			}
+			if(!same_bytes<N>(copies, count*sizeof(T))){
+				report(EVENT_NOTVERIFIED, this);
+				return RHS_ENOTVERIFIED;
+			}
+			return RHS_EOK;
+		}
+		
+		/**
+		 * Correct errors in the array.
+		 * Chunks whose copies match are only read.
+		 * @return RHS_EOK if the array is corrected.
+		 */
+		rhs_error_t correct() {
+			const size_t bytes = count*sizeof(T);
+			rhs_error_t ret = RHS_EOK;
+			for(size_t offset = 0; offset < bytes; offset += CHUNK){
+				const size_t len = std::min<size_t>(CHUNK, bytes - offset);
+				uint8_t* copies[N];
+				for(unsigned int c = 0; c < N; ++c){
+					copies[c] = base + c*stride + offset;
+				}
+				if(same_bytes<N>(copies, len)){
+					continue;
+				}
+				int changed = vote_bytes<N>(copies, len);
+				if(changed < 0){
+					report(EVENT_NOTCORRECTED, this, static_cast<int>(offset / CHUNK));
+					ret = RHS_ENOTCORRECTED;
+				}else{
+					report(EVENT_CORRECTED, this, static_cast<int>(offset / CHUNK), changed);
+				}
+			}
+			return ret;
+		}
+		
+		/**
+		 * Verify the integrity of the array and correct errors.
+		 * @return RHS_EOK if the array is verified or corrected.
+		 */
+		rhs_error_t verifyAndCorrect() {
+			rhs_error_t ret = verify();
+			if(ret == RHS_ENOTVERIFIED){
+				ret = correct();
+			}
+			return ret;
+		}
+	
+	private:
+		/**
+		 * Allocate the copies for count and align.
+		 */
+		void allocate() {
+			stride = (count*sizeof(T) + align - 1) / align * align;
+			base = (stride > 0) ? static_cast<uint8_t*>(::operator new(N*stride, std::align_val_t(align))) : nullptr;
+		}
+		
+		/**
+		 * Exchange the copies with another array, leaving registration alone.
+		 * @param p Other array.
+		 */
+		void swap(tmr_array& p) {
+			std::swap(count, p.count);
+			std::swap(align, p.align);
+			std::swap(stride, p.stride);
+			std::swap(base, p.base);
+		}
+		
+		/**
+		 * Free the copies.
+		 */
+		void release() {
+			if(base != nullptr){
+				::operator delete(base, std::align_val_t(align));
+				base = nullptr;
+			}
+		}
+		
+		/**
+		 * Copies of an element.
+		 * @param i Index.
+		 * @param copies Receives the address of each copy.
+		 */
+		void element(size_t i, uint8_t** copies) const {
+			for(unsigned int c = 0; c < N; ++c){
+				copies[c] = base + c*stride + i*sizeof(T);
+			}
+		}
+		
+		size_t count;            ///< Number of elements.
+		size_t align;            ///< Alignment of each copy in bytes.
+		size_t stride = 0;       ///< Bytes from one copy to the next.
+		uint8_t* base = nullptr; ///< Copies, one after the other.
+};
+
+} // namespace rhs
+
+#endif // _RHS_TMRARRAY_H_
@@ -0,0 +1,282 @@
+/**
+ * @file rhs/tmrexpr.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Expression templates for tmr_obj arithmetic.
+ */
+
+#ifndef _RHS_TMREXPR_H_
+#define _RHS_TMREXPR_H_
+
+#include "registry.h"
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace rhs {
+
+template<typename T, unsigned int N, typename Reg>
+class tmr_obj;
+
+/**
+ * Arithmetic over tmr_obj replicas, evaluated when assigned.
+ * An expression is evaluated by calling prepare() once, which votes every
+ * tmr_obj operand, and then replica(i) for each replica i, which computes
+ * the expression from replica i of every operand.  Expressions hold
+ * references to their tmr_obj operands and must not outlive the full
+ * expression that created them.
+ *
+ * Every expression type has:
+ * - value_type, the type of the result.
+ * - replicas, the number of replicas, 0 for scalars.
+ * - prepare(), which votes the tmr_obj operands.
+ * - replica(i), which evaluates replica i.
+ */
+
+/**
+ * tmr_obj operand.
+ * @tparam T Type of wrapped object.
+ * @tparam N Number of redundant copies.
+ * @tparam Reg Registry policy.
+ */
+template<typename T, unsigned int N, typename Reg>
+class tmr_leaf {
+	public:
+		typedef T value_type;
+		static constexpr unsigned int replicas = N;
+		
+		/**
+		 * Constructor.
+		 * @param obj Operand.
+		 */
+		explicit tmr_leaf(tmr_obj<T, N, Reg>& obj) :
+			obj(obj)
+		{}
+		
+		/** Vote the operand. */
+		void prepare() const {
+			obj.verifyAndCorrect();
+		}
+		
+		/** Replica i of the operand. */
+		const T& replica(unsigned int i) const {
+			return obj[i];
+		}
+	
+	private:
+		tmr_obj<T, N, Reg>& obj; ///< Operand.
+};
+
+/**
+ * Read-only tmr_obj operand.
+ * The operand cannot be corrected, so it is not voted; an upset in one of
+ * its copies changes only that replica of the result, which is outvoted
+ * when the result is.
+ * @tparam T Type of wrapped object.
+ * @tparam N Number of redundant copies.
+ * @tparam Reg Registry policy.
+ */
+template<typename T, unsigned int N, typename Reg>
+class tmr_const_leaf {
+	public:
+		typedef T value_type;
+		static constexpr unsigned int replicas = N;
+		
+		/**
+		 * Constructor.
+		 * @param obj Operand.
+		 */
+		explicit tmr_const_leaf(const tmr_obj<T, N, Reg>& obj) :
+			obj(obj)
+		{}
+		
+		/** Nothing to vote. */
+		void prepare() const {}
+		
+		/** Replica i of the operand. */
+		const T& replica(unsigned int i) const {
+			return obj[i];
+		}
+	
+	private:
+		const tmr_obj<T, N, Reg>& obj; ///< Operand.
+};
+
+/**
+ * Unprotected operand, the same in every replica.
+ * @tparam T Type of operand.
+ */
+template<typename T>
+class tmr_scalar {
+	public:
+		typedef T value_type;
+		static constexpr unsigned int replicas = 0;
+		
+		/**
+		 * Constructor.
+		 * @param value Operand.
+		 */
+		explicit tmr_scalar(const T& value) :
+			value(value)
+		{}
+		
+		/** Nothing to vote. */
+		void prepare() const {}
+		
+		/** The operand. */
+		const T& replica(unsigned int) const {
+			return value;
+		}
+	
+	private:
+		T value; ///< Operand.
+};
+
+/**
+ * Binary operation.
+ * @tparam Op Operation, e.g. std::plus<>.
+ * @tparam L Left expression.
+ * @tparam R Right expression.
+ */
+template<typename Op, typename L, typename R>
+class tmr_binary {
+	static_assert(L::replicas == 0 || R::replicas == 0 || L::replicas == R::replicas, "Operands must have the same number of copies");
+	
+	public:
+		typedef decltype(Op()(std::declval<typename L::value_type>(), std::declval<typename R::value_type>())) value_type;
+		static constexpr unsigned int replicas = (L::replicas != 0) ? L::replicas : R::replicas;
+		
+		/**
+		 * Constructor.
+		 * @param l Left operand.
+		 * @param r Right operand.
+		 */
+		tmr_binary(const L& l, const R& r) :
+			l(l),
+			r(r)
+		{}
+		
+		/** Vote the operands. */
+		void prepare() const {
+			l.prepare();
+			r.prepare();
+		}
+		
+		/** Replica i of the result. */
+		value_type replica(unsigned int i) const {
+			return Op()(l.replica(i), r.replica(i));
+		}
+		
+		/**
+		 * Evaluate the expression.
+		 * @return Voted result.
+		 */
+		operator value_type() const {
+			tmr_obj<value_type, replicas, unregistered> ret(*this);
+			return ret;
+		}
+	
+	private:
+		L l; ///< Left operand.
+		R r; ///< Right operand.
+};
+
+/**
+ * Whether a type is a tmr_obj or an expression over one.
+ */
+template<typename E>
+struct is_tmr_expr : std::false_type {};
+
+template<typename T, unsigned int N, typename Reg>
+struct is_tmr_expr<tmr_obj<T, N, Reg>> : std::true_type {};
+
+template<typename Op, typename L, typename R>
+struct is_tmr_expr<tmr_binary<Op, L, R>> : std::true_type {};
+
+/**
+ * Operand as an expression.
+ * @param obj tmr_obj operand.
+ * @return Leaf referring to obj.
+ */
+template<typename T, unsigned int N, typename Reg>
+tmr_leaf<T, N, Reg> tmr_operand(tmr_obj<T, N, Reg>& obj) {
+	return tmr_leaf<T, N, Reg>(obj);
+}
+
+/**
+ * Operand as an expression.
+ * @param obj Read-only tmr_obj operand.
+ * @return Leaf referring to obj.
+ */
+template<typename T, unsigned int N, typename Reg>
+tmr_const_leaf<T, N, Reg> tmr_operand(const tmr_obj<T, N, Reg>& obj) {
+	return tmr_const_leaf<T, N, Reg>(obj);
+}
+
+/**
+ * Operand as an expression.
+ * @param e Expression operand.
+ * @return e.
+ */
+template<typename Op, typename L, typename R>
+const tmr_binary<Op, L, R>& tmr_operand(const tmr_binary<Op, L, R>& e) {
+	return e;
+}
+
+/**
+ * Operand as an expression.
+ * @param value Unprotected operand.
+ * @return Scalar holding value.
+ */
+template<typename T, typename = std::enable_if_t<!is_tmr_expr<std::decay_t<T>>::value>>
+tmr_scalar<std::decay_t<T>> tmr_operand(const T& value) {
+	return tmr_scalar<std::decay_t<T>>(value);
+}
+
+/**
+ * Expression type of an operand.
+ */
+template<typename X>
+using tmr_operand_t = std::decay_t<decltype(tmr_operand(std::declval<X&>()))>;
+
+/**
+ * Combine two operands.
+ * @tparam Op Operation.
+ * @param l Left operand.
+ * @param r Right operand.
+ * @return Expression.
+ */
+template<typename Op, typename L, typename R>
+tmr_binary<Op, tmr_operand_t<L>, tmr_operand_t<R>> tmr_combine(L& l, R& r) {
+	return tmr_binary<Op, tmr_operand_t<L>, tmr_operand_t<R>>(tmr_operand(l), tmr_operand(r));
+}
+
+/**
+ * Enabled if either operand is a tmr_obj or an expression.
+ */
+template<typename L, typename R>
+using enable_if_tmr_t = std::enable_if_t<is_tmr_expr<std::decay_t<L>>::value || is_tmr_expr<std::decay_t<R>>::value, int>;
+
+template<typename L, typename R, enable_if_tmr_t<L, R> = 0>
+auto operator+(L&& l, R&& r) {
+	return tmr_combine<std::plus<>>(l, r);
+}
+
+template<typename L, typename R, enable_if_tmr_t<L, R> = 0>
+auto operator-(L&& l, R&& r) {
+	return tmr_combine<std::minus<>>(l, r);
+}
+
+template<typename L, typename R, enable_if_tmr_t<L, R> = 0>
+auto operator*(L&& l, R&& r) {
+	return tmr_combine<std::multiplies<>>(l, r);
+}
+
+template<typename L, typename R, enable_if_tmr_t<L, R> = 0>
+auto operator/(L&& l, R&& r) {
+	return tmr_combine<std::divides<>>(l, r);
+}
+
+} // namespace rhs
+
+#endif // _RHS_TMREXPR_H_
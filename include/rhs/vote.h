@@ -0,0 +1,199 @@
+/**
+ * @file rhs/vote.h
+ * @author Conlan Wesson
+ * @copyright (c) 2022, Conlan Wesson All rights reserved.
+ * Bitwise majority voting over redundant copies.
+ */
+
+#ifndef _RHS_VOTE_H_
+#define _RHS_VOTE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace rhs {
+
+/**
+ * Number of bits needed to count to N.
+ * @param n Count.
+ * @return Bits.
+ */
+constexpr unsigned int vote_counter_bits(unsigned int n) {
+	return (n == 0) ? 0 : 1 + vote_counter_bits(n >> 1);
+}
+
+/**
+ * Bitwise majority of N words.
+ * Each bit of the result is set if more than half of the words have it set.
+ * For N = 3 this is (a&b)|(a&c)|(b&c); larger N add the words into
+ * bit-sliced counters and compare them against N/2.
+ * @tparam N Number of words.
+ * @tparam W Word type, an unsigned integer.
+ * @param w Words.
+ * @param tie Set to the bits where exactly half of the words agree, always
+ * zero for odd N.
+ * @return Majority word.
+ */
+template<unsigned int N, typename W>
+inline W majority(const W* w, W& tie) {
+	static_assert(N >= 2, "Voting needs at least two copies");
+	if constexpr(N == 2){
+		tie = w[0] ^ w[1];
+		return w[0] & w[1];
+	}else if constexpr(N == 3){
+		tie = 0;
+		return (w[0] & w[1]) | (w[0] & w[2]) | (w[1] & w[2]);
+	}else{
+		constexpr unsigned int BITS = vote_counter_bits(N);
+		W count[BITS] = {};
+		for(unsigned int i = 0; i < N; ++i){
+			W carry = w[i];
+			for(unsigned int b = 0; b < BITS; ++b){
+				W next = count[b] & carry;
+				count[b] ^= carry;
+				carry = next;
+			}
+		}
+		// Compare the counters against N/2, most significant bit first
+		constexpr unsigned int HALF = N / 2;
+		W greater = 0;
+		W equal = ~W(0);
+		for(unsigned int b = BITS; b-- > 0;){
+			if(HALF & (1u << b)){
+				equal &= count[b];
+			}else{
+				greater |= equal & count[b];
+				equal &= ~count[b];
+			}
+		}
+		tie = (N % 2 == 0) ? equal : W(0);
+		return greater;
+	}
+}
+
+/**
+ * Check whether N copies of an object are bitwise identical.
+ * @tparam N Number of copies.
+ * @param copies Copies.
+ * @param size Size of each copy in bytes.
+ * @return true if every copy matches the first.
+ */
+template<unsigned int N>
+inline bool same_bytes(const uint8_t* const* copies, size_t size) {
+	const uint8_t* p[N];
+	for(unsigned int c = 0; c < N; ++c){
+		p[c] = copies[c];
+	}
+	const size_t words = size / sizeof(uint64_t);
+	uint64_t diff = 0;
+	for(size_t i = 0; i < words; ++i){
+		uint64_t first;
+		memcpy(&first, p[0] + i*sizeof(uint64_t), sizeof(first));
+		for(unsigned int c = 1; c < N; ++c){
+			uint64_t w;
+			memcpy(&w, p[c] + i*sizeof(uint64_t), sizeof(w));
+			diff |= first ^ w;
+		}
+	}
+	for(size_t i = words*sizeof(uint64_t); i < size; ++i){
+		for(unsigned int c = 1; c < N; ++c){
+			diff |= p[0][i] ^ p[c][i];
+		}
+	}
+	return diff == 0;
+}
+
+/**
+ * Check whether every bit of N copies has a strict majority.
+ * @tparam N Number of copies.
+ * @param copies Copies.
+ * @param size Size of each copy in bytes.
+ * @return true if no bit is tied.
+ */
+template<unsigned int N>
+inline bool vote_decided(const uint8_t* const* copies, size_t size) {
+	const uint8_t* p[N];
+	for(unsigned int c = 0; c < N; ++c){
+		p[c] = copies[c];
+	}
+	const size_t words = size / sizeof(uint64_t);
+	uint64_t ties = 0;
+	for(size_t i = 0; i < words; ++i){
+		uint64_t w[N];
+		for(unsigned int c = 0; c < N; ++c){
+			memcpy(&w[c], p[c] + i*sizeof(uint64_t), sizeof(w[c]));
+		}
+		uint64_t tie;
+		majority<N>(w, tie);
+		ties |= tie;
+	}
+	for(size_t i = words*sizeof(uint64_t); i < size; ++i){
+		uint8_t w[N];
+		for(unsigned int c = 0; c < N; ++c){
+			w[c] = p[c][i];
+		}
+		uint8_t tie;
+		majority<N>(w, tie);
+		ties |= tie;
+	}
+	return ties == 0;
+}
+
+/**
+ * Overwrite N copies of an object with their bitwise majority.
+ * Every copy is written, so the loop has no branches and vectorizes for
+ * N = 3.  Upsets in different bits of different copies are all repaired.
+ * @tparam N Number of copies.
+ * @param copies Copies.
+ * @param size Size of each copy in bytes.
+ * @return Number of copies that differed from the majority, or -1 if some
+ * bit has no majority (only for even N), in which case nothing is written.
+ */
+template<unsigned int N>
+inline int vote_bytes(uint8_t* const* copies, size_t size) {
+	if constexpr(N % 2 == 0){
+		if(!vote_decided<N>(copies, size)){
+			return -1;
+		}
+	}
+	uint8_t* p[N];
+	for(unsigned int c = 0; c < N; ++c){
+		p[c] = copies[c];
+	}
+	const size_t words = size / sizeof(uint64_t);
+	uint64_t diff[N] = {};
+	for(size_t i = 0; i < words; ++i){
+		uint64_t w[N];
+		for(unsigned int c = 0; c < N; ++c){
+			memcpy(&w[c], p[c] + i*sizeof(uint64_t), sizeof(w[c]));
+		}
+		uint64_t tie;
+		uint64_t m = majority<N>(w, tie);
+		for(unsigned int c = 0; c < N; ++c){
+			diff[c] |= w[c] ^ m;
+			memcpy(p[c] + i*sizeof(uint64_t), &m, sizeof(m));
+		}
+	}
+	for(size_t i = words*sizeof(uint64_t); i < size; ++i){
+		uint8_t w[N];
+		for(unsigned int c = 0; c < N; ++c){
+			w[c] = p[c][i];
+		}
+		uint8_t tie;
+		uint8_t m = majority<N>(w, tie);
+		for(unsigned int c = 0; c < N; ++c){
+			diff[c] |= w[c] ^ m;
+			p[c][i] = m;
+		}
+	}
+	int changed = 0;
+	for(unsigned int c = 0; c < N; ++c){
+		changed += (diff[c] != 0);
+	}
+	return changed;
+}
+
+} // namespace rhs
+
+#endif // _RHS_VOTE_H_
@@ -6,8 +6,21 @@
  */
 
 #include "rhs/edacmemory.h"
+#include "rhs/rscodec.h"
+#include "rhs/ecccontainer.h"
+#include "rhs/eccregion.h"
+#include "rhs/scrubber.h"
+#include "rhs/tmrarray.h"
+#include "rhs/atomictmr.h"
+#include "rhs/redundant.h"
 #include "rhs/rhsbool.h"
 #include <iostream>
+#include <cstring>
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <utility>
 
 class test {
 	public:
@@ -16,7 +29,7 @@ class test {
 			_b(b)
 		{}
 		
-		int sum() {
+		int sum() const {
 			return _a + _b;
 		}
 		
@@ -29,8 +42,71 @@ class test {
 		int _b;
 };
 
+struct padded {
+	char c;
+	int i;
+	
+	bool operator==(const padded& p) const {
+		return c == p.c && i == p.i;
+	}
+};
+
 #define TEST(_x) (std::cout << ((_x) ? "PASS" : "FAIL") << " " << #_x << std::endl)
 
+/**
+ * Unprotected access to the object in an ecc_obj, for injecting errors.
+ * @param obj Protected object.
+ * @return Pointer to the wrapped object.
+ */
+template<typename T, typename... P>
+T* raw(rhs::ecc_obj<T, P...>& obj) {
+	return const_cast<T*>(std::as_const(obj).operator->());
+}
+
+/**
+ * Encode, update, check and decode a shortened block with an rs_codec.
+ * @tparam C Codec.
+ * @return true if every step gave the expected result.
+ */
+template<typename C>
+bool codec_roundtrip() {
+	typedef typename C::symbol_t symbol_t;
+	const int pad = C::NN / 2;
+	const int len = C::NN - C::NROOTS - pad;
+	std::vector<symbol_t> block(len + C::NROOTS);
+	for(int i = 0; i < len; ++i){
+		block[i] = static_cast<symbol_t>((i*7 + 3) & C::NN);
+	}
+	C::encode(block.data(), &block[len], pad);
+	bool ok = C::check(block.data(), &block[len], pad) == 0;
+	
+	symbol_t delta = 5;
+	block[1] ^= delta;
+	C::update(&block[len], 1, &delta, 1, pad);
+	std::vector<symbol_t> parity(C::NROOTS);
+	C::encode(block.data(), parity.data(), pad);
+	ok = ok && std::equal(parity.begin(), parity.end(), block.begin() + len);
+	
+	std::vector<symbol_t> bad(block);
+	bad[0] ^= 1; // inject symbol errors
+	bad[len-1] ^= C::NN;
+	int pos[C::NROOTS];
+	return ok && C::decode(bad.data(), pos, 0, pad) == 2 && bad == block;
+}
+
+int pure_calls = 0; ///< Runs of pure_square().
+
+/**
+ * Square, declared const so the compiler may merge calls with the same
+ * argument.  The count of runs shows whether it did.
+ * @param x Number.
+ * @return x*x.
+ */
+__attribute__((noinline, const)) int pure_square(int x) {
+	++pure_calls;
+	return x*x;
+}
+
 int main(){
 	rhs::ecc_obj<test> a = rhs::make_ecc<test>(12, 30);
 	
@@ -39,14 +115,14 @@ int main(){
 	TEST((*a)._b == 30);
 	TEST(a->sum() == 42);
 	
-	a->_a = 13; // inject bit error
+	raw(a)->_a = 13; // inject bit error
 	
 	std::cout << (*a)._a << "+" << (*a)._b << "=" << a->sum() << std::endl;
 	TEST((*a)._a == 12);
 	TEST((*a)._b == 30);
 	TEST(a->sum() == 42);
 	
-	a->_a = 13;
+	raw(a)->_a = 13;
 	a.update();
 	TEST((*a)._a == 13);
 	
@@ -55,6 +131,332 @@ int main(){
 	TEST((*a)._b == 30);
 	TEST(a->sum() == 43);
 	
+	const rhs::ecc_obj<test>& ca = a;
+	TEST(ca.verify() == RHS_EOK);
+	TEST(ca->_b == 30);
+	raw(a)->_b = 31; // inject bit error
+	TEST(ca.verify() == RHS_ENOTVERIFIED);
+	TEST(a.correct() == RHS_ENOTVERIFIED);
+	TEST(ca.verify() == RHS_EOK);
+	TEST((*ca)._b == 30);
+	
+	int old = a->_b;
+	raw(a)->_b = 32;
+	a.update_field(&test::_b, old);
+	TEST(ca.verify() == RHS_EOK);
+	raw(a)->_a = 14;
+	a.update_field(&test::_a);
+	TEST(ca.verify() == RHS_EOK);
+	TEST(a->sum() == 46);
+	
+	rhs::ecc_obj<test, rhs::ccsds_codec> e = rhs::make_ecc<test, rhs::ccsds_codec>(1, 2);
+	raw(e)->_b = 3; // inject bit error
+	TEST(e->sum() == 3);
+	
+	rhs::ecc_obj<int> d(7);
+	TEST(sizeof(d) < 64);
+	*raw(d) ^= 0x00FF0000; // inject bit error
+	TEST(*d == 7);
+	
+	unsigned char block[255];
+	for(unsigned int i = 0; i < 223; ++i){
+		block[i] = i*7 + 1;
+	}
+	set_rs_8_mode(RS_8_PORT);
+	encode_rs_8(block, &block[223], 0);
+	for(int mode = RS_8_SSSE3; mode <= RS_8_AVX2; ++mode){
+		if(set_rs_8_mode(static_cast<rs_8_mode>(mode))){
+			unsigned char simd[255];
+			memcpy(simd, block, 223);
+			encode_rs_8(simd, &simd[223], 0);
+			TEST(memcmp(simd, block, 255) == 0);
+			
+			simd[3] ^= 0x10; // inject bit errors
+			simd[100] ^= 0xFF;
+			simd[230] ^= 0x01;
+			TEST(decode_rs_8(simd, NULL, 0, 0) == 3);
+			TEST(memcmp(simd, block, 255) == 0);
+		}
+	}
+	set_rs_8_mode(RS_8_AUTO);
+	
+	unsigned char fast[255];
+	int pos[32];
+	memcpy(fast, block, 255);
+	fast[10] ^= 0x01; // inject bit errors
+	fast[240] ^= 0x80;
+	TEST(decode_rs_8(fast, pos, 0, 0) == 2);
+	TEST(memcmp(fast, block, 255) == 0);
+	TEST(std::min(pos[0], pos[1]) == 10 && std::max(pos[0], pos[1]) == 240);
+	
+	typedef rhs::rs_codec<8, 0x187, 112, 11, 32> rs_255_223;
+	unsigned char parity[32];
+	rs_255_223::encode(block, parity, 0);
+	TEST(memcmp(parity, &block[223], 32) == 0);
+	TEST(rs_255_223::check(block, &block[223], 0) == 0);
+	unsigned char chien[255];
+	int cpos[32];
+	memcpy(chien, block, 255);
+	chien[10] ^= 0x01; // same errors as the fast path, general decoder
+	chien[240] ^= 0x80;
+	TEST(rs_255_223::decode(chien, cpos, 0, 0) == 2);
+	TEST(cpos[0] == pos[0] && cpos[1] == pos[1]);
+	
+	typedef rhs::rs_codec<4, 0x13, 1, 1, 4> rs_15_11;
+	typedef rhs::rs_codec<12, 0x1053, 1, 1, 8> rs_4095_4087;
+	TEST(codec_roundtrip<rs_15_11>() && codec_roundtrip<rs_4095_4087>());
+	
+	typedef rhs::rs_codec<8, 0x11d, 1, 1, 16> rs_255_239;
+	rhs::ecc_obj<test, rs_255_239> f = rhs::make_ecc<test, rs_255_239>(4, 5);
+	raw(f)->_a = 6; // inject bit error
+	TEST(f->sum() == 9);
+	
+	std::vector<rhs::ecc_obj<test>> g;
+	for(int i = 0; i < 100; ++i){
+		g.push_back(rhs::make_ecc<test>(i, i));
+	}
+	rhs_error_t results[100];
+	TEST(rhs::verify_all(g) == RHS_EOK);
+	raw(g[42])->_a = 0; // inject bit error
+	TEST(rhs::verify_all(g, results) == RHS_ENOTVERIFIED);
+	TEST(results[42] == RHS_ENOTVERIFIED && results[41] == RHS_EOK);
+	
+	std::vector<rhs::ecc_obj<std::array<int, 200>>> h(10);
+	TEST(rhs::verify_all(h) == RHS_EOK);
+	(*raw(h[7]))[199] = 1; // inject bit error in the shortened last block
+	TEST(rhs::verify_all(h, results) == RHS_ENOTVERIFIED);
+	TEST(results[7] == RHS_ENOTVERIFIED && results[6] == RHS_EOK);
+	
+	rhs::ecc_obj<std::array<int, 200>> k;
+	int* kp = raw(k)->data();
+	for(int i = 100; i < 105; ++i){
+		kp[i] = -1; // inject 20 byte errors, more than 16 unknown errors
+	}
+	TEST(k.correct(100*sizeof(int), 5*sizeof(int)) == RHS_ENOTVERIFIED);
+	TEST(k.verify() == RHS_EOK);
+	TEST(kp[100] == 0 && kp[104] == 0);
+	
+	rhs::thread_pool pool(4);
+	rhs::set_executor(&pool, 2);
+	auto l = std::make_unique<rhs::ecc_obj<std::array<uint8_t, 100000>>>();
+	TEST(l->verify() == RHS_EOK);
+	uint8_t* lp = raw(*l)->data();
+	lp[0] = 1; // inject bit errors in the first and last blocks
+	lp[99999] = 1;
+	TEST(l->verify() == RHS_ENOTVERIFIED);
+	TEST(l->correct() == RHS_ENOTVERIFIED);
+	TEST(l->verify() == RHS_EOK);
+	TEST(lp[0] == 0 && lp[99999] == 0);
+	rhs::set_executor(nullptr);
+	TEST(l->verify() == RHS_EOK);
+	
+	rhs::ecc_array<int, 1000> m;
+	for(int i = 0; i < 1000; ++i){
+		m.set(i, i);
+	}
+	TEST(m.verify() == RHS_EOK);
+	const rhs::ecc_array<int, 1000>& cm = m;
+	const_cast<int&>(cm[500]) = 7; // inject bit error
+	TEST(m[500] == 500);
+	TEST(m.verify() == RHS_EOK);
+	int sum = 0;
+	for(int x : m){
+		sum += x;
+	}
+	TEST(sum == 999*1000/2);
+	
+	rhs::ecc_vector<double> n;
+	for(int i = 0; i < 100; ++i){
+		n.push_back(i);
+	}
+	TEST(n.size() == 100 && n[99] == 99);
+	n.pop_back();
+	n.resize(200);
+	TEST(n.size() == 200 && n[99] == 0 && n[98] == 98);
+	TEST(n.verify() == RHS_EOK);
+	n.resize(50);
+	n.resize(100);
+	TEST(n.size() == 100 && n[49] == 49 && n[50] == 0 && n[99] == 0);
+	TEST(n.verify() == RHS_EOK);
+	TEST(std::is_const<std::remove_reference<decltype(*n.begin())>::type>::value);
+	TEST(std::is_const<std::remove_reference<decltype(n[0])>::type>::value);
+	
+	rhs::ecc_obj<test, rhs::conventional_codec, rhs::verify_epoch> o = rhs::make_ecc<test, rhs::conventional_codec, rhs::verify_epoch>(1, 2);
+	TEST(o->sum() == 3);
+	raw(o)->_a = 2; // inject bit error, not seen until the next epoch
+	TEST(o->sum() == 4);
+	rhs::bump_epoch();
+	TEST(o->sum() == 3);
+	
+	rhs::ecc_obj<test, rhs::conventional_codec, rhs::verify_window<0>> q = rhs::make_ecc<test, rhs::conventional_codec, rhs::verify_window<0>>(1, 2);
+	raw(q)->_a = 2; // inject bit error, an empty window always verifies
+	TEST(q->sum() == 3);
+	
+	rhs::ecc_obj<std::array<int, 200>> r;
+	{
+		auto w = r.write();
+		static_cast<int*>(w.bytes(0, sizeof(int)))[0] = 5;
+		static_cast<int*>(w.bytes(150*sizeof(int), sizeof(int)))[0] = 6;
+	}
+	TEST(r.verify() == RHS_EOK);
+	TEST((*r)[0] == 5 && (*r)[150] == 6);
+	{
+		auto w = f.write();
+		w.set(&test::_b, 10);
+	}
+	TEST(f.verify() == RHS_EOK);
+	TEST(f->sum() == 14);
+	f.write()->_a = 5; // re-encoded at the end of the statement
+	TEST(f.verify() == RHS_EOK);
+	TEST(f->sum() == 15);
+	
+	rhs::ecc_obj<test, rhs::conventional_codec, rhs::verify_scrubbed> sc = rhs::make_ecc<test, rhs::conventional_codec, rhs::verify_scrubbed>(1, 2);
+	raw(sc)->_a = 2; // inject bit error, never seen by a read
+	sc.write().set(&test::_b, 3); // same block, corrected before re-encoding
+	TEST(sc.verify() == RHS_EOK);
+	TEST(sc->sum() == 4);
+	
+	rhs::ecc_region<> u(3*sysconf(_SC_PAGESIZE));
+	uint8_t* up = static_cast<uint8_t*>(u.data());
+	TEST(up != nullptr && u.dirty_pages() == 0);
+	up[u.size()/2] = 1; // plain write, tracked by a write fault
+	TEST(up[u.size()/2] == 1 && u.dirty_pages() == 1);
+	TEST(u.commit() == 1 && u.dirty_pages() == 0);
+	TEST(u.verify() == RHS_EOK);
+	mprotect(up, u.size(), PROT_READ | PROT_WRITE);
+	up[u.size()/2] = 2; // inject bit error, bypassing the tracking
+	mprotect(up, u.size(), PROT_READ);
+	TEST(u.verify() == RHS_ENOTVERIFIED);
+	TEST(u.correct() == RHS_ENOTVERIFIED);
+	TEST(up[u.size()/2] == 1 && u.verify() == RHS_EOK);
+	up[u.size()/2] = 3; // the repair left the page protected, still tracked
+	TEST(u.dirty_pages() == 1 && u.commit() == 1 && u.verify() == RHS_EOK);
+	std::atomic<bool> committing{true};
+	std::thread correcting([&]() {
+		while(committing){
+			u.correct(); // must not undo a commit
+		}
+	});
+	int reverted = 0;
+	for(int i = 1; i <= 2000; ++i){
+		up[u.size()/2] = static_cast<uint8_t>(i);
+		u.commit();
+		reverted += (up[u.size()/2] != static_cast<uint8_t>(i));
+	}
+	committing = false;
+	correcting.join();
+	TEST(reverted == 0 && u.verify() == RHS_EOK);
+	std::vector<std::unique_ptr<rhs::ecc_region<>>> regions;
+	try{
+		while(regions.size() < rhs::page_tracker::MAX_REGIONS){
+			regions.emplace_back(new rhs::ecc_region<>(1));
+		}
+	}catch(const std::bad_alloc&){
+		// Out of slots, u is live
+	}
+	TEST(regions.size() == rhs::page_tracker::MAX_REGIONS - 1);
+	regions.clear();
+	
+	{
+		rhs::scrubber s(std::chrono::milliseconds(1));
+		rhs::ecc_obj<test, rhs::conventional_codec, rhs::verify_scrubbed> v = rhs::make_ecc<test, rhs::conventional_codec, rhs::verify_scrubbed>(1, 2);
+		rhs::tmr_obj<int> w(5);
+		s.add(v);
+		s.add(w);
+		{
+			std::lock_guard<rhs::scrubber> lock(s);
+			raw(v)->_a = 2; // inject bit errors
+			w[0] = 6;
+			TEST(v->sum() == 4);
+		}
+		size_t passes = s.passes();
+		while(s.passes() < passes + 2){
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		s.remove(v);
+		s.remove(w);
+		TEST(v->sum() == 3 && w[0] == 5);
+		TEST(s.errors() == 2 && s.failures() == 0);
+	}
+	
+	{
+		typedef rhs::ecc_obj<test, rhs::conventional_codec, rhs::verify_always, rhs::registered> reg_ecc;
+		typedef rhs::tmr_obj<int, 3, rhs::registered> reg_tmr;
+		size_t before = rhs::registry::size();
+		reg_ecc proto = rhs::make_ecc<test, rhs::conventional_codec, rhs::verify_always, rhs::registered>(1, 2);
+		std::vector<reg_ecc> x(9, proto);
+		reg_tmr y(5);
+		TEST(rhs::registry::size() == before + 11);
+		std::thread([&]() {
+			reg_ecc z(x[0]);
+			TEST(rhs::registry::size() == before + 12);
+		}).join();
+		raw(x[3])->_a = 7; // inject bit errors
+		y[1] = 6;
+		size_t bad = 0;
+		rhs::registry::for_each([&](const rhs::registry_entry& e) {
+			if(e.verify() != RHS_EOK){
+				++bad;
+				e.correct();
+			}
+		});
+		TEST(bad == 2 && y[1] == 5);
+		raw(x[2])->_a = 9; // inject bit errors, found through the registry
+		y[2] = 7;
+		{
+			rhs::scrubber rs(std::chrono::milliseconds(1), 4, rhs::scrubber::REGISTRY);
+			size_t passes = rs.passes();
+			while(rs.passes() < passes + 2){
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			TEST(rs.errors() == 2 && rs.failures() == 0);
+		}
+		TEST(x[2].verify() == RHS_EOK && y[2] == 5);
+		x.erase(x.begin() + 4, x.end());
+		TEST(rhs::registry::size() == before + 6);
+	}
+	
+	rhs::event events[rhs::event_ring::CAPACITY];
+	rhs::event_ring& ring = rhs::telemetry::ring();
+	ring.drain(events, rhs::event_ring::CAPACITY);
+	uint64_t corrected = ring.count(rhs::EVENT_CORRECTED);
+	rhs::ecc_obj<std::array<int, 200>> t;
+	int* tp = raw(t)->data();
+	tp[150] = 1; // inject bit error in block 2
+	TEST(t.correct() == RHS_ENOTVERIFIED);
+	TEST(ring.count(rhs::EVENT_CORRECTED) == corrected + 1);
+	TEST(ring.drain(events, rhs::event_ring::CAPACITY) == 1);
+	TEST(events[0].type == rhs::EVENT_CORRECTED && events[0].obj == tp && events[0].block == 2 && events[0].symbols == 1);
+	std::unique_ptr<rhs::event_ring> local_ring(new rhs::event_ring);
+	std::vector<std::thread> recorders;
+	for(int t = 0; t < 4; ++t){
+		recorders.emplace_back([&]() {
+			rhs::event e = {rhs::EVENT_NOTVERIFIED, nullptr, -1, 0, 0};
+			for(int i = 0; i < 1000; ++i){
+				local_ring->record(e);
+			}
+		});
+	}
+	for(auto& t : recorders){
+		t.join();
+	}
+	TEST(local_ring->count(rhs::EVENT_NOTVERIFIED) == 4000 && local_ring->dropped() == 4000 - rhs::event_ring::CAPACITY);
+	
+	typedef rhs::ecc_obj<int, rhs::conventional_codec, rhs::verify_always, rhs::unregistered, rhs::arena_parity> split_int;
+	std::vector<split_int> sv(100, split_int(7));
+	TEST(sizeof(split_int) < sizeof(rhs::ecc_obj<int>) && rhs::verify_all(sv) == RHS_EOK);
+	*raw(sv[42]) = 8; // inject bit error
+	TEST(*sv[42] == 7 && *sv[41] == 7);
+	typedef rhs::parity_arena<32> arena32;
+	arena32::handle ph = arena32::allocate();
+	TEST(sizeof(split_int) == sizeof(int) + sizeof(ph) && reinterpret_cast<uintptr_t>(arena32::data(ph)) % 32 == 0);
+	arena32::release(ph);
+	std::thread([&]() {
+		std::vector<split_int> moved(std::move(sv)); // released by another thread, which exits
+	}).join();
+	std::vector<split_int> sw(100, split_int(9));
+	TEST(rhs::verify_all(sw) == RHS_EOK && *sw[99] == 9);
+	
 	rhs::boolean b(rhs_true);
 	if(b == rhs_true){
 		std::cout << "true" << std::endl;
@@ -66,6 +468,7 @@ int main(){
 	
 	rhs::tmr_obj<int> c(3);
 	TEST(c == 3);
+	TEST(!std::is_polymorphic<rhs::tmr_obj<int>>::value && sizeof(c) == 3*sizeof(int));
 	
 	c += 2;
 	
@@ -82,5 +485,115 @@ int main(){
 	std::cout << "20/5=" << c << std::endl;
 	TEST(c == 4);
 	
+	c[0] ^= 1; // inject a different bit error in every copy
+	c[1] ^= 2;
+	c[2] ^= 4;
+	TEST(c.verify() == RHS_ENOTVERIFIED && c.correct() == RHS_EOK && c[0] == 4 && c[1] == 4 && c[2] == 4);
+	
+	rhs::tmr_obj<int> ta(2), tb(3), tc(0);
+	ta[1] = 9; // inject bit error
+	tc = ta*tb + c;
+	TEST(tc.verify() == RHS_EOK && tc == 10 && ta[1] == 2);
+	
+	tc -= ta*2;
+	int td = tc*tb - 1;
+	TEST(tc == 6 && td == 17);
+	const rhs::tmr_obj<int>& ctb = tb;
+	tb[2] = 4; // inject bit error, outvoted in the result
+	rhs::tmr_obj<int> te = ctb*2 + ta;
+	TEST(te == 8 && te.verify() == RHS_EOK && tb[2] == 4);
+	
+	rhs::tmr_obj<std::array<int, 100>, 5> big(std::array<int, 100>{});
+	big[0][10] = 1;
+	big[3][10] = 2;
+	big[4][99] = -1;
+	TEST(big.correct() == RHS_EOK && big.verify() == RHS_EOK && big[3][10] == 0 && big[4][99] == 0);
+	
+	rhs::tmr_obj<int, 4> even(6);
+	even[0] = 7;
+	even[1] = 7;
+	TEST(even.correct() == RHS_ENOTCORRECTED && even[2] == 6);
+	
+	rhs::tmr_obj<padded> pad(padded{1, 2});
+	reinterpret_cast<uint8_t*>(&pad[1])[1] = 0xA5; // padding is not part of the value
+	TEST(pad.verify() == RHS_EOK);
+	pad[2].i = 3; // inject error
+	TEST(pad.correct() == RHS_EOK && pad[2].i == 2);
+	
+	rhs::tmr_array<int> tt(1000, 5);
+	tt.replica(1)[10] = 7; // inject bit errors
+	tt.replica(2)[500] ^= 1;
+	tt.replica(0)[999] ^= 8;
+	TEST(tt.verify() == RHS_ENOTVERIFIED && tt[10] == 5 && tt.replica(1)[10] == 5);
+	TEST(tt.correct() == RHS_EOK && tt.verify() == RHS_EOK && tt[500] == 5 && tt[999] == 5);
+	rhs::tmr_array<int> tw(3, 1);
+	tw = tt;
+	TEST(tw.size() == 1000 && tw.verify() == RHS_EOK && tw[999] == 5);
+	
+	rhs::tmr_array<double, 5> tv(10, 1.5, true);
+	tv.replica(4)[3] = 2.5; // inject bit error
+	const rhs::tmr_array<double, 5>& ctv = tv;
+	TEST(reinterpret_cast<uintptr_t>(tv.replica(1)) % sysconf(_SC_PAGESIZE) == 0 && ctv[3] == 1.5 && tv.verifyAndCorrect() == RHS_EOK && tv.replica(4)[3] == 1.5);
+	
+	rhs::atomic_tmr<int> at(5);
+	at.upset(1, 2); // inject bit error
+	TEST(at.verify() == RHS_ENOTVERIFIED && at.load() == 5 && at.verify() == RHS_EOK);
+	int expected = 4;
+	TEST(!at.compare_exchange_strong(expected, 9) && expected == 5 && at.compare_exchange_strong(expected, 9) && at == 9);
+	at.upset(0, 1);
+	TEST(at.fetch_add(3) == 9 && at.exchange(1) == 12 && at.verify() == RHS_EOK);
+	at.upset(0, 1);
+	at.upset(1, 2);
+	TEST(at.correct() == RHS_ENOTCORRECTED && at.verify() == RHS_EOK);
+	at.upset(2, uint64_t(1) << 40); // inject bit error in the version, ahead of the others
+	TEST(at.exchange(7) == 0 && at.verify() == RHS_EOK && at == 7);
+	
+	rhs::atomic_tmr<uint64_t> wide(0xFFFFFFFF);
+	wide.upset(1, uint64_t(1) << 63); // inject bit error above 32 bits
+	TEST(wide.fetch_add(1) == 0xFFFFFFFF && wide.load() == 0x100000000 && wide.verify() == RHS_EOK);
+	int pointee = 0;
+	rhs::atomic_tmr<int*> ptr(&pointee);
+	ptr.upset(2, 8); // inject bit error
+	TEST(ptr.load() == &pointee && ptr.verify() == RHS_EOK);
+	
+	rhs::atomic_tmr<uint32_t> counter;
+	std::atomic<bool> counting{true};
+	std::thread upsets([&]() {
+		for(uint32_t i = 0; counting; ++i){
+			counter.upset(2, 1u << (i % 32)); // inject bit error
+			counter.correct();
+		}
+	});
+	std::vector<std::thread> adders;
+	for(int t = 0; t < 4; ++t){
+		adders.emplace_back([&]() {
+			for(int i = 0; i < 10000; ++i){
+				counter.fetch_add(1);
+			}
+		});
+	}
+	for(auto& t : adders){
+		t.join();
+	}
+	counting = false;
+	upsets.join();
+	TEST(counter.load() == 40000 && counter.verify() == RHS_EOK);
+	
+	int runs = 0;
+	auto flaky = [&](int x) { return (++runs == 2) ? x ^ 16 : x * 2; }; // upset in the second run
+	TEST(rhs::redundant_invoke(flaky, 21) == 42 && runs == 3);
+	TEST(rhs::redundant_invoke(pure_square, 7) == 49 && pure_calls == 3);
+	
+	rhs::thread_pool replicas(3);
+	std::atomic<int> sums{0};
+	auto add = [&](const std::vector<int>& v) {
+		std::atomic<long> total{0};
+		replicas.parallel_for(v.size(), [&](size_t i) { total += v[i]; }); // nested batch runs serially
+		return (sums++ == 0) ? total + 1 : total.load();
+	};
+	std::vector<int> values(1000, 3);
+	TEST(rhs::redundant_invoke<5>(&replicas, add, values) == 3000 && sums == 5);
+	TEST(rhs::redundant_invoke(nullptr, flaky, 4) == 8);
+	
 	return 0;
 }